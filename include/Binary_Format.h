@@ -0,0 +1,51 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Binary input format (".bin" files), in native byte order:
+//   Binary_Header
+//   int32 N[D]                 padded to 8 bytes
+//   int32 column[d][ncells]    for d in [0, D-1], each padded to 8 bytes
+//   double value[ncells]
+// The cells are sorted in lexicographic order, without duplicates,
+// so the file can be mapped and used as it is.
+struct Binary_Header{
+	char magic[8];		// "GGCBIN1"
+	int32_t D;
+	int32_t reserved;
+	int64_t E;
+	int64_t ncells;
+	double Ew;
+};
+
+const char binary_magic[8] = "GGCBIN1";
+
+inline size_t binary_padded(size_t bytes){
+	return (bytes + 7) & ~size_t(7);
+}
@@ -31,46 +31,47 @@
 #include <fstream>
 
 #include "Rectangle.h"
+#include "Rectangle_Pool.h"
+#include "Query.h"
 
-typedef std::vector<std::shared_ptr<std::vector<int>>> rect_structure;
+typedef std::vector<Module> rect_structure;
 
 class Brick{
 	public:
 		int dim;
 		std::vector<int> nodes;
-		
-		std::vector<int>::iterator brick_cursor;
-		std::vector<int>::iterator rect_cursor;
 
-		static double weight;
-		static double info;
-		static int non_zero;
-		static rect_structure* r;
 		static std::vector<std::string> spaces;
 
 	public:
 		Brick(int d);
 		virtual ~Brick();
 		
-		//Processing Rectangle
-		virtual void get_weight();
-		virtual void get_info();
-		virtual void get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value);
-		virtual void get_non_zero(Rectangle* R);
+		//Processing Rectangle (read only, the cursors live in the calls)
+		virtual void query(Query_Context& q) const;
+		//Weights of the fragments, n is the fragment number of the path so far
+		virtual void fragment_query(Fragment_Context& q, int n) const;
+		virtual void get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value) const;
+		virtual void get_cells(std::vector<int>& coords, std::vector<double>& values, std::vector<int>& path);
 		//Tree construction	
 		virtual Brick* insert_Node_Brick(int dim, int node);
 		virtual Brick* insert_Data_Brick(int dim, int node);
 		virtual void insert_value(int node, double value);
+		//Bulk construction, the nodes come in increasing order
+		virtual Brick* append_Node_Brick(int dim, int node);
+		virtual Brick* append_Data_Brick(int dim, int node);
+		virtual void append_value(int node, double value);
 		virtual void normalize(double Eg);
 
 		//print
 		virtual void print_bricks();
 		virtual void print_data_on_file(std::ofstream& datafile, int N);
+		virtual size_t memory_footprint();
 
 
-		virtual void make_micro(std::vector<Rectangle*>& R, rect_structure* rect);
+		virtual void make_micro(std::vector<Rectangle*>& R, rect_structure* rect, Rectangle_Pool& pool);
 		//virtual void atomise(Rectangle* ref_rect, std::vector<Rectangle*>& new_Rs);
-		virtual void shrink(rect_structure* rect);
+		virtual void shrink(const Rectangle& r, std::vector<std::vector<int>>& found) const;
 
 };
 
@@ -33,6 +33,9 @@
 
 #include "Generater.h"
 #include "Reader.h"
+#include "Rectangle_Pool.h"
+#include "Slot_Map.h"
+#include "Id_Set.h"
 
 class Builder{
 	
@@ -40,27 +43,43 @@ class Builder{
 		// rect_structure is the core element of a Rectangle.
 		// A two dimensional rectangles contains two vectors of integers designating indexes of nodes
 		// The rect_structure is a vector that contains pointers to those two vectors
-		typedef std::vector<std::shared_ptr<std::vector<int>>> rect_structure;
+		typedef std::vector<Module> rect_structure;
 
 		// register is the full data structure of the registers.
 		// The three levels correspond to:
 		// 1 - A dimension,
 		// 2 - A node id
-		// 3 - A vector of Rectangles
-		// Therefore registre[0][5] is the vector of all the rectangles containing the node 5 on their 0 dimension
-		typedef std::vector< std::vector< std::vector<Rectangle*>>> registre;
-
-		//regit is a vector of iterators on the re
-		typedef std::vector< std::vector< std::vector<Rectangle*>>::iterator > regit;
+		// 3 - A set of rectangle ids (see Slot_Map)
+		// Therefore registre[0][5] is the set of the ids of all the rectangles containing the node 5 on their 0 dimension
+		typedef std::vector< std::vector<Id_Set>> registre;
+
+		//regit is a vector of iterators on the registers of each dimension
+		typedef std::vector< std::vector<Id_Set>::iterator > regit;
+
+		// An id entering or leaving the register of a node, waiting in the batch.
+		// seq keeps the order of the edits of a same id.
+		struct Register_Edit{
+			int node, id, seq;
+			bool insert;
+			bool operator<(const Register_Edit& e) const {
+				return node != e.node ? node < e.node : id != e.id ? id < e.id : seq < e.seq;
+			}
+		};
 
 
 		int Rsize; //Size of the partition
 
-		//Partitions
-		std::vector<Rectangle*> R, R_check, buffer;
+		//Partitions. R is a dense array, its rectangles are moved by insert_R and erase_R
+		std::vector<Rectangle*> R, R_check;
+		Slot_Map slot_map;			// Rectangle of each id
+		std::vector<int> R_index;	// Position in R of each id
 
 		//Registers
 		registre reg;
+		//Batch of edits not yet applied to the registers, per dimension, see patch_registers
+		std::vector<std::vector<Register_Edit>> register_edits;
+		std::vector<std::vector<char>> dirty_nodes;		// 1 if the node has edits in the batch
+		std::vector<int> patch_del, patch_add;
 		
 		//Meta data
 		int D, E;
@@ -71,23 +90,39 @@ class Builder{
 
 		//Data
 		Data_Tree* data_tool;
+		bool owns_data = true;	// False when the data is shared with another object, read only
+
+		//Storage of the rectangles, recycled from one operation to the next
+		Rectangle_Pool pool;
 	
 		
-		Builder(std::vector<int> N, std::vector<double> params);
-		Builder(std::string input_filename);
-		Builder(std::string type, int n);
+		Builder(std::vector<int> N, std::vector<double> params, std::string layout = "brick");
+		Builder(std::string input_filename, std::string layout = "brick");
+		Builder(std::string type, int n, std::string layout = "brick");
 		Builder(std::vector<int> N);
+		Builder(Data_Tree* shared_data);
 		Builder();
 		~Builder();
 		
 		void macro();
 		void micro();
+		void start_from(const std::vector<Rectangle*>& partition);
 		void build_R();
 		void build_R(std::vector<Rectangle*>& R);
 		void clean_R();
 		void clean_R(std::vector<Rectangle*>& R);
+		void insert_R(Rectangle* r);
+		void erase_R(Rectangle* r);
+		void index_R();
+		bool is_live(const Rectangle* r) const;
 		void reg_of_R();
+		void ids_of_registers(const std::vector<Id_Set>& registers, std::vector<Rectangle*>& R);
 		void clean_registers();
+		void edit_register(int d, int node, int id, bool insert);
+		void edit_registers(Rectangle* r, bool insert);
+		void patch_registers();
+		void clear_register_edits();
+		size_t register_edits_size() const;
 
 		std::vector<Rectangle*>* copy_partition();
 		void copy_partition(std::vector<Rectangle*>* R_copy);
@@ -44,16 +44,17 @@ class Checker : public Builder {
 		std::vector<int> nnz_cells;	// id of non-zero cells in data
 		std::vector<int>::iterator dup;	// Iterator on duplicated cell
 		std::vector<int> missing_cells;	// Missing elements
-		std::vector< std::vector<int>::iterator> rect_it;	// Iterator on rectangle components
+		std::vector<Module::const_iterator> rect_it;	// Iterator on rectangle components
 		regit reg_it;		// Iterator on registers
 		registre reg_copy;	// Copy of registers
 	
 	public:
 		//using Builder::Builder;
-		Checker(std::vector<int> N, std::vector<double> params);
-		Checker(std::string input_filename);
-		Checker(std::string type, int n);
+		Checker(std::vector<int> N, std::vector<double> params, std::string layout = "brick");
+		Checker(std::string input_filename, std::string layout = "brick");
+		Checker(std::string type, int n, std::string layout = "brick");
 		Checker(std::vector<int> N);
+		Checker(Data_Tree* shared_data);
 		Checker();
 		~Checker();
 		void init(); 
@@ -27,6 +27,8 @@
 #pragma once
 #include <tuple> 
 #include <utility>
+#include <thread>
+#include <atomic>
 
 #include "Optimizer.h"
 
@@ -39,17 +41,24 @@ class Compressor : public Optimizer{
 		double d_lambda;
 		double gap;
 		int nsearch;
+		int nthreads = 1;					// Restarts of optimization_program run at the same time
+		std::vector<unsigned> restart_seeds;	// One per restart, drawn before they run
+		bool warm_start = false;			// Start each lambda from the best explored neighbour instead of micro
+		int warm_perturbation = 0;			// Random divisions applied to a warm start by each restart
 
 		std::pair<double, double> current_interval;
 		
-		std::vector<std::vector<Rectangle*>*> partitions;
-		
 		std::vector<storage> explored_lambda;
 		std::vector<storage> homogeneous_solutions;
 		std::vector<storage> to_print;
-		std::vector<storage>::iterator low_explo, up_explo, c_explo, h_explo;
+		std::vector<storage>::iterator low_explo, up_explo;
 		storage optim_trials;
 
+		// Lower envelope of the explored partitions, envelope[i] is the best
+		// partition from its lambda to breakpoints[i]
+		std::vector<storage> envelope;
+		std::vector<double> breakpoints;
+
 		// Chronos
 	    std::chrono::steady_clock::time_point t_start, t_stop;
 		std::chrono::duration<double> total_time;
@@ -60,11 +69,11 @@ class Compressor : public Optimizer{
 
 	public:
 		Compressor(std::vector<int> N, std::vector<double> params, double lambda,
-			double gap, int nsearch);
+			double gap, int nsearch, std::string layout = "brick");
 		Compressor(std::string input_filename, double lambda,
-			double gap, int nsearch);
+			double gap, int nsearch, std::string layout = "brick");
 		Compressor(std::string type, int n, double lambda,
-			double gap, int nsearch);
+			double gap, int nsearch, std::string layout = "brick");
 		Compressor();
 		~Compressor();
 
@@ -72,13 +81,22 @@ class Compressor : public Optimizer{
 		
 		void dichotomic_search();
 		void dichotomic_search_no_check();
+		void pareto_search();
 
 		void optimization_program();
+		void restart(Optimizer& G, unsigned seed, std::vector<Rectangle*>* start = nullptr);
+		std::vector<Rectangle*>* warm_partition(std::vector<storage>::iterator low, double l);
+		void run_restarts(std::vector<storage>& trials);
+		void parallel_sweep();
 		void clean_optimization_program();
 		void update_storage(storage& S);
 
 		void full_check_solution_dichotomic_search();
 		void make_homogeneous();
+		void lower_envelope(std::vector<storage> lines);
+		void evaluate(const storage& S);
+		double cost_at(const storage& S, double l);
+		double crossing(const storage& a, const storage& b);
 
 		void test_weak_low();
 		void test_weak_up();
@@ -92,8 +110,11 @@ class Compressor : public Optimizer{
 		void print_explored_lambda();
 		void print_to_print();
 		void print_optim_trials();
+		void print_envelope();
 
 		void write_partitions(std::vector<storage>& S);
+		void write_envelope();
+		void write_archive();
 		
 };
 
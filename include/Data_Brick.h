@@ -31,6 +31,7 @@
 #include <iomanip>
 
 #include "Brick.h"
+#include "Sorted_Set.h"
 class Data_Brick: public Brick{
 	protected:
 		std::vector<double> datas;
@@ -39,17 +40,19 @@ class Data_Brick: public Brick{
 		Data_Brick(int d);
 		~Data_Brick();
 		
-		void get_weight();
-		void get_info();
-		void get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value);
-		void get_non_zero(Rectangle* R);
+		void query(Query_Context& q) const;
+		void fragment_query(Fragment_Context& q, int n) const;
+		void get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value) const;
+		void get_cells(std::vector<int>& coords, std::vector<double>& values, std::vector<int>& path);
 
 		void insert_value(int node, double value);
+		void append_value(int node, double value);
 		void normalize(double Eg);
 		void print_bricks();
+		size_t memory_footprint();
 		void print_data_on_file(std::ofstream& datafile, int N);
 
-		void make_micro(std::vector<Rectangle*>& R, rect_structure* rect);
+		void make_micro(std::vector<Rectangle*>& R, rect_structure* rect, Rectangle_Pool& pool);
 		//void atomise(Rectangle* ref_rect, std::vector<Rectangle*>& new_Rs);
-		void shrink(rect_structure* rect);
+		void shrink(const Rectangle& r, std::vector<std::vector<int>>& found) const;
 	};
\ No newline at end of file
@@ -40,56 +40,101 @@
 #include "Brick.h"
 #include "Node_Brick.h"
 #include "Data_Brick.h"
+#include "Fiber_Tree.h"
+#include "Binary_Format.h"
+#include "Parallel_Sort.h"
 
 
 class Data_Tree {
 	public:
-		typedef std::vector<std::shared_ptr<std::vector<int>>> rect_structure;
+		typedef std::vector<Module> rect_structure;
 		
 		//Brick structure
 		Brick* working_brick;
 		std::vector<Brick*> nodes;
 
+		//Flat structure, replaces the bricks when layout is "fiber"
+		std::string layout;
+		Fiber_Tree* fiber;
+
 		//metadata and data
 		int D, E;
 		double value, Ew;
 		std::vector<int> N;
-		std::vector<int> shifts;
 		std::vector<int> hyperlinks;
 
 	public:
-		Data_Tree(std::vector<int> N);
+		Data_Tree(std::vector<int> N, std::string layout = "brick");
+		Data_Tree(std::string layout);
 		Data_Tree();
 		virtual ~Data_Tree();
 
 
 		//Build data tree
 		void make_bricks();
+		void insert_cells(std::vector<int> coords, std::vector<double> values);
+		bool insert_columns(const std::vector<const int*>& columns, const double* values, size_t n);
+		void make_layout();
+		static void sort_cells(const std::vector<int>& N, std::vector<int>& coords, std::vector<double>& values);
 		// void normalize();
 
-		//Use data tree
-		void get_weight(Rectangle* R);
-		void get_info(Rectangle* R);
-		void get_nnz(std::vector<int>& nnz_cells);
-		void get_non_zero(Rectangle* R);
+		//Use data tree (read only, safe to share between threads)
+		Query_Result query(const Rectangle* R, int fields = QUERY_ALL) const;
+		Query_Result query(const Module_View* modules, int fields = QUERY_ALL) const;
+		double get_weight(const Rectangle* R) const;
+		//Weights of the 2^D fragments of R, inside[d] flags the nodes of the operating rectangle
+		void fragment_weights(const Rectangle* R, const std::vector<std::vector<char>>& inside, std::vector<double>& weights) const;
+		double get_info(const Rectangle* R) const;
+		int get_non_zero(const Rectangle* R) const;
+		void get_nnz(std::vector<int>& nnz_cells) const;
 		
 		//Print data_tree
 		void make_brick_spaces();
 		void print_data();	
 		void print_metadata();
 		void print_data_on_file(std::string filename);
+		void get_cells(std::vector<int>& coords, std::vector<double>& values);
+		bool write_binary(std::string filename);
+		size_t memory_footprint();
 
 		//Build a Partition from the dataset
-		void make_micro(std::vector<Rectangle*>& R);
+		void make_micro(std::vector<Rectangle*>& R, Rectangle_Pool& pool) const;
 		//void atomise(Rectangle* ref_rect, std::vector<Rectangle*>& new_Rs);
-		void shrink(Rectangle* R);
+		void shrink(Rectangle* R) const;
 
 		//debug
 		std::vector<std::vector <int>>* make_macro_rectangle();
 		std::vector<std::vector <int>>* make_random_rectangle();
 		void printRectangle(const Rectangle& r);
 
-		template <typename T> void print(T& s){
+		//Build the bricks in one pass over sorted cells without duplicates,
+		//coord(e, d) is the node of cell e on dimension d
+		template <typename C> void build_bricks(size_t n, C coord, const double* values){
+			std::vector<Brick*> path(D);
+			for(size_t e = 0; e < n; e++){
+				int first = 0;
+				if(e > 0)
+					while(first < D-1 and coord(e, first) == coord(e-1, first))
+						first++;
+				if(first == 0){
+					if(D == 2)
+						nodes[coord(e, 0)] = new Data_Brick(1);
+					else
+						nodes[coord(e, 0)] = new Node_Brick(1);
+					path[0] = nodes[coord(e, 0)];
+					first = 1;
+				}
+				for(int d = first; d < D-1; d++){
+					if(d == D-2)
+						path[d] = path[d-1]->append_Data_Brick(d+1, coord(e, d));
+					else
+						path[d] = path[d-1]->append_Node_Brick(d+1, coord(e, d));
+				}
+				path[D-2]->append_value(coord(e, D-1), values[e]);
+			}
+		}
+
+		template <typename T> void print(const T& s) const{
 			for (typename T::value_type elem : s)
 			{std::cout << elem << ' ';}
     	std::cout << std::endl;
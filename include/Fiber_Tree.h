@@ -0,0 +1,121 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <iomanip>
+
+#include "Rectangle.h"
+#include "Rectangle_Pool.h"
+#include "Query.h"
+#include "Sorted_Set.h"
+
+// Flat storage of the data in contiguous arrays (compressed sparse fibers).
+// Level 0 is dense: the fibers of node i on level 1 are in [ptr[0][i], ptr[0][i+1]).
+// Levels 1 to D-1 store sorted node ids in idx[d]. For d < D-1 the children of
+// idx[d][j] on level d+1 are in [ptr[d][j], ptr[d][j+1]).
+// The last level carries the values. For D == 2 this is the CSR layout.
+// The last level and the values can also be views on external sorted
+// columns (a mapped binary file), in which case they are not copied.
+class Fiber_Tree{
+	typedef std::vector<Module> rect_structure;
+
+	public:
+		int D;
+		std::vector<int> N;
+
+		std::vector<std::vector<int>> ptr;	// ptr[d] for d in [0, D-2]
+		std::vector<std::vector<int>> idx;	// idx[d] for d in [1, D-1], idx[0] is empty
+		std::vector<double> vals;			// Values of the cells, aligned with idx[D-1]
+
+		//Read access to the levels, in idx and vals or in external columns
+		std::vector<const int*> level;		// level[d] for d in [1, D-1]
+		const double* cell_vals;
+		size_t ncells;
+
+	public:
+		Fiber_Tree(std::vector<int> N);
+		~Fiber_Tree();
+
+		//Build from cells sorted in lexicographic order (coords has D ints per cell)
+		void build(const std::vector<int>& coords, const std::vector<double>& values);
+		//Build on top of sorted columns without duplicates (columns[d][e] is the node of cell e
+		//on dimension d). The last column and the values are not copied and must outlive the tree.
+		bool build(const std::vector<const int*>& columns, const double* values, size_t n);
+
+		//Use fiber tree (read only)
+		void query(Query_Context& q) const;
+		void fragment_query(Fragment_Context& q) const;
+		void get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts) const;
+		void make_micro(std::vector<Rectangle*>& R, Rectangle_Pool& pool) const;
+		void shrink(const Rectangle& r, std::vector<std::vector<int>>& found) const;
+		void get_cells(std::vector<int>& coords, std::vector<double>& values) const;
+		size_t level_size(int d) const;
+
+		//Print
+		void print_data();
+		void print_data_on_file(std::ofstream& datafile);
+
+		size_t memory_footprint();
+
+	private:
+		// Calls f(j) for every position j in [begin, end) of level d
+		// whose node belongs to the module m (both sides are sorted)
+		template <typename F> void for_each_common(int d, int begin, int end, const Module_View& m, F f) const{
+			Sorted_Set::for_each_match(level[d] + begin, end - begin, m.data(), m.size(), [&](int j){
+				f(begin + j);
+			});
+		}
+
+		// Calls leaf(j) for every cell j of the rectangle r
+		template <typename F> void for_each_cell(const Module_View* r, F leaf) const{
+			for(int v : r[0])
+				if(ptr[0][v] < ptr[0][v+1])
+					for_each_cell(1, ptr[0][v], ptr[0][v+1], r, leaf);
+		}
+
+		template <typename F> void for_each_cell(int d, int begin, int end, const Module_View* r, F& leaf) const{
+			if(d == D-1)
+				for_each_common(d, begin, end, r[d], leaf);
+			else
+				for_each_common(d, begin, end, r[d], [&](int j){
+					for_each_cell(d+1, ptr[d][j], ptr[d][j+1], r, leaf);
+				});
+		}
+
+		void fragment_query(int d, int begin, int end, Fragment_Context& q, int n) const;
+
+		void bind();
+		void make_micro(int d, int j, std::vector<int>& path, std::vector<Rectangle*>& R, Rectangle_Pool& pool) const;
+		void get_nnz(int d, int j, int value, std::vector<int>& nnz_cells, std::vector<int>& shifts) const;
+		void shrink(int d, int begin, int end, const Rectangle& r, std::vector<std::vector<int>>& found) const;
+		void get_cells(int d, int j, std::vector<int>& path, std::vector<int>& coords, std::vector<double>& values) const;
+};
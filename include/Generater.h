@@ -55,12 +55,17 @@ class Generater: public Data_Tree{
 		//Poisson law
 		double rate;
 
+		//Generated cells, before insertion
+		std::vector<int> cells;
+		std::vector<double> cell_values;
+
 	public:
-		Generater(std::vector<int> N, std::vector<double> params);
-		Generater(std::string type, int n);
+		Generater(std::vector<int> N, std::vector<double> params, std::string layout = "brick");
+		Generater(std::string type, int n, std::string layout = "brick");
 		Generater();
 		~Generater();
 		
+		void add_cell(int i, int j, double value);
 		void setup_constants();
 		void build_social_model();
 		void build_multiscale_complete_matrix(int n);
@@ -0,0 +1,98 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Set of rectangle ids, compressed the way roaring bitmaps are. The ids are
+// grouped in chunks of 2^16 by their high bits. A chunk keeps the sorted low
+// bits of its ids while it has at most array_max of them, and a bitset of
+// 1024 words beyond. Registers hold one set per node, so that the union of
+// the registers of a module is a sequence of word ORs on the hub nodes.
+class Id_Set{
+	public:
+		static const int chunk_bits = 16;
+		static const int chunk_words = (1 << chunk_bits)/64;
+		static const int array_max = 4096;
+
+	private:
+		struct Chunk{
+			int key;						// id >> chunk_bits
+			int count;
+			std::vector<uint16_t> array;	// Low bits, while count <= array_max
+			std::vector<uint64_t> bits;		// chunk_words words, beyond
+		};
+		std::vector<Chunk> chunks;			// Sorted by key
+		size_t count;
+
+	public:
+		Id_Set() : count(0){}
+
+		bool insert(int id);
+		bool erase(int id);
+		bool contains(int id) const;
+		// Erase the ids of del then insert the ids of add, both sorted, in one
+		// pass over each chunk they touch
+		void patch(const std::vector<int>& del, const std::vector<int>& add);
+		void clear(){chunks.clear(); count = 0;}
+
+		size_t size() const {return count;}
+		bool empty() const {return count == 0;}
+		// i-th smallest id
+		int select(size_t i) const;
+
+		// Set the bits of the ids in a bitset of n_words words
+		void or_into(uint64_t* words, size_t n_words) const;
+
+		// Calls f(id) in increasing order
+		template <typename F> void for_each(F f) const{
+			for(const Chunk& c : chunks){
+				int base = c.key << chunk_bits;
+				if(c.bits.empty())
+					for(uint16_t low : c.array)
+						f(base | low);
+				else
+					for(int w = 0; w < chunk_words; w++)
+						for(uint64_t word = c.bits[w]; word; word &= word - 1)
+							f(base | (w << 6) | __builtin_ctzll(word));
+			}
+		}
+
+		std::vector<int> ids() const;
+		bool operator==(const Id_Set& s) const;
+		bool operator!=(const Id_Set& s) const {return !(*this == s);}
+		// The chunks are sorted, their counts and their containers agree
+		bool is_valid() const;
+		size_t memory_footprint() const;
+
+	private:
+		std::vector<Chunk>::iterator find_chunk(int key);
+		std::vector<Chunk>::const_iterator find_chunk(int key) const;
+		static void to_bits(Chunk& c);
+		static void to_array(Chunk& c);
+};
@@ -0,0 +1,119 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+class Module;
+
+// Read only view on the sorted nodes of a module, wherever they are stored
+// (the contiguous buffer of a rectangle or a Module)
+class Module_View{
+	const int* first;
+	const int* last;
+
+	public:
+		typedef int value_type;
+		typedef const int* iterator;
+		typedef const int* const_iterator;
+
+		Module_View() : first(nullptr), last(nullptr){}
+		Module_View(const int* first, const int* last) : first(first), last(last){}
+		Module_View(const Module& m);
+
+		const int* begin() const {return first;}
+		const int* end() const {return last;}
+		size_t size() const {return last - first;}
+		bool empty() const {return first == last;}
+		int operator[](size_t i) const {return first[i];}
+		int front() const {return *first;}
+		int back() const {return *(last-1);}
+		const int* data() const {return first;}
+
+		bool operator==(const Module_View& m) const;
+		bool operator!=(const Module_View& m) const {return !(*this == m);}
+};
+
+// A module is the set of nodes of a rectangle on one dimension, used while
+// an operation is being built. The nodes are always kept as a sorted array,
+// which is what the data and the registers read. When the nodes are small
+// integers (the dimension has at most max_bitset_nodes nodes), a bitset of
+// the nodes is built on demand and cached, so that the modules of the
+// rectangles are split against it by testing one bit per node.
+class Module{
+	public:
+		typedef int value_type;
+		typedef const int* iterator;
+		typedef const int* const_iterator;
+
+		static const int max_bitset_nodes = 1024;
+
+	private:
+		std::vector<int> ids;
+		mutable std::vector<uint64_t> words;
+		mutable bool words_valid;
+
+	public:
+		Module() : words_valid(false){}
+		Module(std::initializer_list<int> nodes) : ids(nodes), words_valid(false){}
+		Module(const std::vector<int>& nodes) : ids(nodes), words_valid(false){}
+		Module(std::vector<int>&& nodes) : ids(std::move(nodes)), words_valid(false){}
+		Module(Module_View nodes) : ids(nodes.begin(), nodes.end()), words_valid(false){}
+
+		//Read access, as a sorted array
+		const int* begin() const {return ids.data();}
+		const int* end() const {return ids.data() + ids.size();}
+		size_t size() const {return ids.size();}
+		bool empty() const {return ids.empty();}
+		int operator[](size_t i) const {return ids[i];}
+		int front() const {return ids.front();}
+		int back() const {return ids.back();}
+		const int* data() const {return ids.data();}
+		const std::vector<int>& nodes() const {return ids;}
+
+		//Nodes must be pushed in increasing order
+		void push_back(int node){ids.push_back(node); words_valid = false;}
+		void reserve(size_t n){ids.reserve(n);}
+		void clear(){ids.clear(); words.clear(); words_valid = true;}
+		void assign(Module_View nodes){ids.assign(nodes.begin(), nodes.end()); words_valid = false;}
+
+		bool operator==(const Module& m) const {return ids == m.ids;}
+		bool operator!=(const Module& m) const {return ids != m.ids;}
+
+		bool has_bitset() const {return ids.empty() or ids.back() < max_bitset_nodes;}
+		const std::vector<uint64_t>& bitset() const;
+		bool contains(int node) const;
+
+		//out = a inter b, a \ b and a union b, out is overwritten
+		static void intersection(Module_View a, const Module& b, Module& out);
+		static void difference(Module_View a, const Module& b, Module& out);
+		static void unite(Module_View a, Module_View b, Module& out);
+		//inter = a inter b and diff = a \ b in one pass
+		static void split(Module_View a, const Module& b, Module& inter, Module& diff);
+};
+
+inline Module_View::Module_View(const Module& m) : first(m.begin()), last(m.end()){}
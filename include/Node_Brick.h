@@ -39,18 +39,21 @@ class Node_Brick: public Brick{
 		Node_Brick(int d);
 		~Node_Brick();
 
-		void get_weight();
-		void get_info();
-		void get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value);
-		void get_non_zero(Rectangle* R);
+		void query(Query_Context& q) const;
+		void fragment_query(Fragment_Context& q, int n) const;
+		void get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value) const;
+		void get_cells(std::vector<int>& coords, std::vector<double>& values, std::vector<int>& path);
 
 		Brick* insert_Node_Brick(int dim, int node);
 		Brick* insert_Data_Brick(int dim, int node);
+		Brick* append_Node_Brick(int dim, int node);
+		Brick* append_Data_Brick(int dim, int node);
 		void normalize(double Eg);
 		void print_bricks();
+		size_t memory_footprint();
 
-		void make_micro(std::vector<Rectangle*>& R, rect_structure* rect);
+		void make_micro(std::vector<Rectangle*>& R, rect_structure* rect, Rectangle_Pool& pool);
 		//void atomise(Rectangle* ref_rect, std::vector<Rectangle*>& new_Rs);
-		void shrink(rect_structure* rect);
+		void shrink(const Rectangle& r, std::vector<std::vector<int>>& found) const;
 
 };
\ No newline at end of file
@@ -25,8 +25,33 @@
 
 
 #pragma once
+#include <unordered_map>
 #include "Operator.h"
 
+// A fragment of a rectangle of to_del, scored by delta_cost and
+// built by do_operation if the operation is accepted
+struct Scored_Fragment{
+	Rectangle* source;		// Rectangle of to_del
+	int n;					// Fragment number, see Operator::fragments
+	double weight;
+};
+
+// An operation recorded by do_operation, undone by rollback. Its rectangles
+// end at removed_end in journal_removed and at added_end in journal_added.
+struct Journal_Entry{
+	int removed_end, added_end;
+	int d_Rsize;
+	double d_dkl, d_ldkl, d_penalty, d_cost;
+};
+
+// Values of a rectangle recalculated by check_objective
+struct Rectangle_Check{
+	double weight = 0;
+	double info = 0;
+	double loss = 0;
+	double dkl = 0;
+};
+
 class Objective : public Operator{	
 	public:
 		double lambda;
@@ -59,17 +84,23 @@ class Objective : public Operator{
 		double ldkl_check;
 		double penalty_check;
 		double cost_check;
+		std::unordered_map<const Rectangle*, Rectangle_Check> checks;	// Per rectangle, filled by check_objective
 
 		// Utils
 		double wR;
-		double Wacc;
-		std::vector<Rectangle*>::iterator max_it;
-		int max_pos;
+		std::vector<double> fragment_weights;	// Weights of the fragments of *k, by fragment number
+		std::vector<Scored_Fragment> scored;	// Fragments of the operation
+
+		// Undo journal, the removed rectangles are shared with it (see start_journal)
+		bool journaling = false;
+		std::vector<Journal_Entry> journal;
+		std::vector<Rectangle*> journal_removed, journal_added;
 
 	public:
-	Objective(std::vector<int> N, std::vector<double> params, double lambda);
-	Objective(std::string input_filename, double lambda);
-	Objective(std::string type, int n, double lambda);
+	Objective(std::vector<int> N, std::vector<double> params, double lambda, std::string layout = "brick");
+	Objective(std::string input_filename, double lambda, std::string layout = "brick");
+	Objective(std::string type, int n, double lambda, std::string layout = "brick");
+	Objective(Data_Tree* shared_data, double lambda);
 	Objective();
 	~Objective();
 
@@ -80,17 +111,18 @@ class Objective : public Operator{
 
 	int check_objective();
 	
-	void calculate_rectangle();
 	void calculate_operation();
 	void delta_cost();
+	void build_operation();
 	void do_operation();
 	void cancel_operation();
+
+	void start_journal();
+	void stop_journal();
+	void clear_journal();
+	void rollback();
 	
 	void print_cost();
 	void print_cost_rectangles();
 };
 
-static bool Compare(Rectangle* a, Rectangle* b)
-{
-    return (a->size < b->size);
-}
@@ -27,20 +27,10 @@
 #pragma once
 
 #include <random>
-#include <queue>
 #include <algorithm>
 #include <iterator>
 #include "Checker.h"
-
-// Used by regUnion2
-class Compare_reg_size
-{
-public:
-  bool operator() (const std::vector<Rectangle*>* lhs, const std::vector<Rectangle*>* rhs) const
-  {
-    return lhs->size() > rhs->size();
-  }
-};
+#include "Sorted_Set.h"
 
 class Operator : public Checker {	
 	typedef std::vector<rect_structure> component_storage;
@@ -61,8 +51,6 @@ class Operator : public Checker {
 	    /****Operations****/
 		int dim;						// Dimension being processed
 	    int n_gen, n;					// Max number of rectangles generated by the division of a rectangle by an operating rectangle, a number to iterate over these generated rectangles 
-	    int pow2d;						// To iterate over the generated rectangles
-		int i_d_selector;				// Intersection/Difference selector
 		std::vector<double> binomial_p; // Temporary, for finding a rectangle
 		
 		// Storage for finding operations
@@ -72,34 +60,34 @@ class Operator : public Checker {
 		Rectangle* new_R;					// New Rectangle
 		std::vector<Rectangle*> new_Rs;		// New parts for partition
 		std::vector<Rectangle*> new_Rs_total; // Used by Objective class
-		rect_structure* rect;				// The operating rectangle
-		rect_structure* new_r;				// For building a rectangle
+		rect_structure rect;				// The operating rectangle, its modules are reused
 
 		// Storage used for various task during calculation of new retangles
-		std::vector<int> sizeCheck;			// Check size of rectangles being build
 		component_storage inter_diffe;		// To store the results of the calculus of intersection of components
-	    std::vector<std::vector<int>> n_move; // Used to know when the shared pointer has to be moved (last copy of component)
+		void (Operator::*fragment_kernel)(bool);	// fragments<D> for the D of the data, chosen once by init()
+		std::vector<int> fragment_ids;		// Non-empty fragments of *k, listed by fragment_kernel
+		std::vector<std::vector<char>> rect_flags;	// Per dimension and node, 1 for the nodes of rect (see flag_rect)
 		// Storage for register intersection calculus
-		std::vector<Rectangle*> to_del; 	// Rectangles to be deleted by the operation on the partition
-		std::vector<std::vector<Rectangle*>> regUnionResult;	// Store the results of the union of the registers on each dimension
-		std::priority_queue<std::vector<Rectangle*>*, std::vector<std::vector<Rectangle*>*>, Compare_reg_size> pq; // For regUnion2
-
-		// Register
-		registre del_reg; // To be deleted Rects in a register shape
-		registre add_reg; // To be added Rects in a register shape
+		std::vector<Rectangle*> to_del; 	// Rectangles to be deleted by the operation on the partition, sorted by id
+		std::vector<std::vector<uint64_t>> regUnionResult;	// Union of the registers on each dimension, as a bitset of ids
+		// Edits kept in the batch before the registers are patched, 0 to patch after each operation.
+		// A lookup in a dirty register patches them all.
+		size_t register_batch_max;
 
 		int check; // Used by the division
 
-		Operator(std::vector<int> N, std::vector<double> params);
-		Operator(std::string input_filename);
-		Operator(std::string type, int n);
+		Operator(std::vector<int> N, std::vector<double> params, std::string layout = "brick");
+		Operator(std::string input_filename, std::string layout = "brick");
+		Operator(std::string type, int n, std::string layout = "brick");
 		Operator(std::vector<int> N);
+		Operator(Data_Tree* shared_data);
 		Operator();
 		~Operator();
 		
 		void init();
 		void setup_registers_and_storage();
 		void testRandomNumberGenerator();
+		void seed(unsigned s);
 
 		int find_cluster();
 		int find_union_constrained();
@@ -108,31 +96,27 @@ class Operator : public Checker {
 
 		void shuffle_partition(int nope);
 		
-		void calculate_rectangle();
 		void calculate_operation();
+		template <int DIM> void fragments(bool inside);
+		int fragment_size(int n) const;
+		Rectangle* make_fragment(int n);
 		void doCluster();
 		void clean_operator();
+		void clear_rect();
+		void flag_rect(char value);
 
 
-		void intersection();
-		void difference();
+		void split();
 
 		
 		void regUnion();
-		void regUnion2();
-		void regUnion_temp(Rectangle* R);
 		void regIntersection();
-		void regIntersection_temp();
 
 
-		void make_del_reg(Rectangle* n);
-		void make_add_reg(Rectangle* n);
-		void clean_temp_registers();
-		void update_registers();
+		void patch_dirty_registers();
+		void replace_rectangles(std::vector<Rectangle*>& new_Rs);
 
 
-		void print_add_reg();
-		void print_del_reg();
 		void print_reg_union();
 		void print_component_storage(component_storage& inter_diffe);
 };
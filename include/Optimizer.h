@@ -30,6 +30,7 @@
 #include <sstream>
 #include <chrono>
 #include <set>
+#include <map>
 #include "Objective.h"
 
 //					0		1		2							3	4		5		6		7		8		
@@ -50,6 +51,11 @@ class Optimizer : public Objective{
   		//Storage for bes solution found
 		storage best_solution;
 
+		//Pareto archive of the visited partitions, by box of Rsize (see archive_partition)
+		bool archiving = false;
+		double pareto_epsilon = 0.01;
+		std::map<int, storage> pareto;
+
 		//Timers
 	    std::chrono::steady_clock::time_point tbegin, tend, tfind, tdelta, tdone, t0;
 		std::chrono::duration<double> optim_time, ope_time;
@@ -57,6 +63,7 @@ class Optimizer : public Objective{
 		//Parameter for file output
 		int data_size;
 		std::vector<double> data;
+		size_t allocated_before;	// pool.allocated when the previous line was written
 		std::string path_to_output_data;
 		std::string filename;
 		std::string meta_filename;
@@ -67,9 +74,10 @@ class Optimizer : public Objective{
 		std::string algorithm;
 
 	public:
-	Optimizer(std::vector<int> N, std::vector<double> params, double lambda);
-	Optimizer(std::string input_filename, double lambda);
-	Optimizer(std::string type, int n, double lambda);
+	Optimizer(std::vector<int> N, std::vector<double> params, double lambda, std::string layout = "brick");
+	Optimizer(std::string input_filename, double lambda, std::string layout = "brick");
+	Optimizer(std::string type, int n, double lambda, std::string layout = "brick");
+	Optimizer(Data_Tree* shared_data, double lambda);
 	Optimizer();
 	~Optimizer();
 	
@@ -93,6 +101,9 @@ class Optimizer : public Objective{
 
 	void restart_from_best();
 
+	void archive_partition();
+	void clear_archive();
+
 	void write_column_names(std::ofstream& file);
 	void write_annexes();
 	void write_header();
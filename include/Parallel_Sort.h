@@ -0,0 +1,67 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+// Sorts [begin, end) with one thread per chunk of at least min_chunk
+// elements, then merges the sorted chunks two by two, also in parallel.
+template <typename It, typename Compare>
+void parallel_sort(It begin, It end, Compare comp, size_t min_chunk = 1 << 16){
+	size_t n = end - begin;
+	size_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+	size_t nchunks = std::min(nthreads, n/min_chunk);
+	if(nchunks <= 1){
+		std::sort(begin, end, comp);
+		return;
+	}
+
+	std::vector<size_t> bounds(nchunks+1);
+	for(size_t c = 0; c <= nchunks; c++)
+		bounds[c] = n*c/nchunks;
+
+	std::vector<std::thread> workers;
+	for(size_t c = 0; c < nchunks; c++)
+		workers.emplace_back([&, c](){
+			std::sort(begin + bounds[c], begin + bounds[c+1], comp);
+		});
+	for(auto& w : workers)
+		w.join();
+
+	for(size_t width = 1; width < nchunks; width *= 2){
+		workers.clear();
+		for(size_t c = 0; c + width < nchunks; c += 2*width){
+			size_t last = std::min(c + 2*width, nchunks);
+			workers.emplace_back([&, c, last](){
+				std::inplace_merge(begin + bounds[c], begin + bounds[c+width], begin + bounds[last], comp);
+			});
+		}
+		for(auto& w : workers)
+			w.join();
+	}
+}
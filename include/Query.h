@@ -0,0 +1,105 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+#include <math.h>
+#include <vector>
+
+#include "Rectangle.h"
+
+// Fields that a query on the data can compute
+enum Query_Field{
+	QUERY_WEIGHT = 1,
+	QUERY_INFO = 2,
+	QUERY_NON_ZERO = 4,
+	QUERY_ALL = 7
+};
+
+// What the data holds inside a rectangle
+struct Query_Result{
+	double weight = 0;
+	double info = 0;
+	int non_zero = 0;
+};
+
+// State of one query. It lives on the caller's stack, so the data
+// can be queried by several threads at the same time.
+struct Query_Context{
+	const Module_View* r;		// Modules being queried, one per dimension
+	int fields;					// Combination of Query_Field
+	Query_Result result;
+
+	Query_Context(const Module_View* r, int fields) : r(r), fields(fields){}
+
+	// Account for a non-zero cell of the rectangle
+	void add(double value){
+		if(fields & QUERY_WEIGHT)
+			result.weight += value;
+		if(fields & QUERY_INFO)
+			result.info += value*log2(value);
+		if(fields & QUERY_NON_ZERO)
+			result.non_zero++;
+	}
+};
+
+// State of a query summing the weights of the 2^D fragments of a rectangle in
+// one traversal. A cell whose node on dimension d is outside the operating
+// rectangle (inside[d][node] == 0) belongs to the fragments whose bit d is set.
+struct Fragment_Context{
+	const Module_View* r;					// Rectangle being split
+	const std::vector<char>* inside;		// Nodes of the operating rectangle, one flag per node
+	double* weights;						// One accumulator per fragment number
+
+	Fragment_Context(const Module_View* r, const std::vector<char>* inside, double* weights) :
+		r(r), inside(inside), weights(weights){}
+
+	// Fragment number n extended by the side of node on dimension d
+	int side(int n, int d, int node) const {return n | (!inside[d][node] << d);}
+};
+
+// The modules of a rectangle, one view per dimension, kept on the
+// stack for the usual small numbers of dimensions
+class Rectangle_Views{
+	static const int stack_dimensions = 16;
+
+	Module_View local[stack_dimensions];
+	std::vector<Module_View> heap;
+	Module_View* modules;
+
+	public:
+		Rectangle_Views(const Rectangle& r) : modules(local){
+			int D = r.dimensions();
+			if(D > stack_dimensions){
+				heap.resize(D);
+				modules = heap.data();
+			}
+			for(int d = 0; d < D; d++)
+				modules[d] = r[d];
+		}
+		Rectangle_Views(const Rectangle_Views&) = delete;
+
+		const Module_View* data() const {return modules;}
+};
@@ -26,8 +26,28 @@
 
 #pragma once
 #include <sstream>
+#include <charconv>
+#include <chrono>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <thread>
+#include <cstring>
 #include "Data_Tree.h"
 
+// Part of a csv file made of whole lines, parsed by one thread
+struct Csv_Chunk{
+	const char* begin;
+	const char* end;
+	std::vector<int> coords;		// (line in the chunk, column) of the non-zero cells
+	std::vector<double> values;
+	int nlines = 0;
+	int ncols = 0;
+	double Ew = 0;
+	int error_line = -1;			// First line that could not be parsed
+};
+
 class Reader : public Data_Tree{
 
 	public:
@@ -40,18 +60,40 @@ class Reader : public Data_Tree{
 		std::string line;
 		std::vector<std::string> data_line;
 
+		//for json streaming
+		std::ifstream data_file;
+		std::vector<char> buffer;
+		size_t buffer_pos, buffer_end, bytes_read;
+		std::vector<std::string> cell_tokens;
+
+		//for binary files, mapped as long as the data tree uses them
+		void* mapping;
+		size_t mapping_size;
+
 	public:
-		Reader(std::string input_filename);
+		Reader(std::string input_filename, std::string layout = "brick");
 		Reader();
 		~Reader();
 
 		void extract_extension();
 		void extract_datas_csv();
 		void extract_datas_json();
+		void extract_datas_bin();
+		static void parse_csv_chunk(Csv_Chunk& chunk);
+
+		//Json parsing, in one pass over the file
+		bool parse_json(std::vector<int>& coords, std::vector<double>& values);
+		bool parse_datas(std::vector<int>& coords, std::vector<double>& values);
+		bool parse_metadatas();
 
 		//Read file utilities
-		void get_metadata(std::ifstream&);
-		int get_data_pos(std::ifstream&);
-		int clean_word(std::string& word);
-		bool no_ket(std::string& word);
+		bool fill_buffer();
+		int peek_char();
+		int next_char();
+		bool expect(char c);
+		bool read_token(std::string& token);
+		bool skip_value();
+		bool to_int(const std::string& token, int& x);
+		bool to_double(const std::string& token, double& x);
+		size_t position();
 };
@@ -32,44 +32,96 @@
 #include <math.h>
 #include <iostream>
 
+#include "Module.h"
+
+// A rectangle keeps all its modules in one buffer of ints: the D ends of the
+// modules, then the sorted nodes of each module one after the other. Small
+// buffers (micro rectangles among others) are stored inside the object, so
+// these rectangles take a single allocation. Modules are never shared between
+// rectangles, they are read through Module_View. A heap buffer is kept when the
+// rectangle is rebuilt with fewer nodes (see Rectangle_Pool).
 class Rectangle{
-	typedef std::vector<std::shared_ptr<std::vector<int>>> rect_structure;
+	typedef std::vector<Module> rect_structure;
 
 	friend class Builder;
 	friend class Checker;
 	friend class Operator;
 	friend class Brick;
+	friend class Rectangle_Pool;
 	public:
+		static const int inline_length = 8;
+
 		int size;
-		std::vector<int> sizes;
-		rect_structure* rectangle;
+		int id;			// Slot in the partition, -1 outside of it (see Slot_Map)
+		int refs;		// Partition and snapshots sharing the rectangle (see Rectangle_Pool::share)
 
 		double weight;
 		double info;
 		double loss;
 		double dkl;
 
-		double weight_check;
-		double info_check;
-		double loss_check;
-		double dkl_check;
-
+	private:
+		int D;
+		int length;		// D + number of nodes
+		union{
+			struct{
+				int* heap;
+				int capacity;
+			};
+			int local[inline_length];
+		};
 
 	public:
-		Rectangle();
-		Rectangle(rect_structure* rectangle);
+		Rectangle(const rect_structure& modules);
+		// module(d) gives the nodes of dimension d (anything with data() and size())
+		template <typename F> Rectangle(int D, F module) : id(-1), refs(1), weight(0), info(0), loss(0), dkl(0), length(0){
+			fill(D, module);
+		}
 		Rectangle(const Rectangle& r);
+		Rectangle& operator=(const Rectangle& r) = delete;
 		~Rectangle();
-				
+
+		int dimensions() const {return D;}
+		Module_View operator[](int d) const{
+			const int* b = buffer();
+			return Module_View(b + D + (d > 0 ? b[d-1] : 0), b + D + b[d]);
+		}
+		//Replace the modules, the objective values are kept
+		void set_modules(const rect_structure& modules);
+		//Copy of the modules, to operate on them
+		rect_structure modules() const;
+
 		void doLoss();
+		//Loss of a rectangle of this weight and size
+		static double loss_of(double weight, int size);
 		void doDKL();
-		
-		void doLossCheck();
-		void doDKLCheck();
 
 		Rectangle* deep_copy();
 
 		bool operator==(const Rectangle& r) const;
-		std::vector<int> &operator[](int i);
-		std::vector<int> &operator[](int i) const;
+		size_t memory_footprint() const;
+
+	private:
+		const int* buffer() const {return length <= inline_length ? local : heap;}
+
+		//Buffer of n ints, the heap buffer is reused if it is large enough
+		int* reserve(int n);
+		void assign(const Rectangle& r);
+
+		template <typename F> void fill(int dims, F module){
+			int nodes = 0;
+			for(int d = 0; d < dims; d++)
+				nodes += module(d).size();
+			D = dims;
+			int* b = reserve(D + nodes);
+			size = 1;
+			int end = 0;
+			for(int d = 0; d < D; d++){
+				auto&& m = module(d);
+				std::copy(m.data(), m.data() + m.size(), b + D + end);
+				end += m.size();
+				b[d] = end;
+				size *= m.size();
+			}
+		}
 };
@@ -0,0 +1,90 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+#include <vector>
+#include <cstddef>
+
+#include "Rectangle.h"
+
+// Recycles the rectangles of the operations and of the partition. The
+// fragments of a rejected move and the rectangles removed from the partition
+// are released here, and the next rectangles are rebuilt in place from them,
+// so that their objects and node buffers are taken from the heap once.
+// Released rectangles with their nodes stored inline and those with a heap
+// buffer are kept apart, so that a heap buffer only serves a large rectangle.
+// The rectangles of a partition are never modified, so a snapshot shares
+// them with the partition, a rectangle is recycled when its last holder
+// releases it.
+class Rectangle_Pool{
+	typedef std::vector<Module> rect_structure;
+
+	std::vector<Rectangle*> small, large;
+
+	public:
+		size_t allocated;	// Objects and node buffers taken from the heap
+		size_t recycled;	// Rectangles rebuilt from released ones
+
+		Rectangle_Pool();
+		Rectangle_Pool(const Rectangle_Pool&) = delete;
+		Rectangle_Pool& operator=(const Rectangle_Pool&) = delete;
+		~Rectangle_Pool();
+
+		// module(d) gives the nodes of dimension d, as for the Rectangle constructor
+		template <typename F> Rectangle* make(int D, F module){
+			int nodes = 0;
+			for(int d = 0; d < D; d++)
+				nodes += module(d).size();
+			Rectangle* r = take(D + nodes);
+			if(r == nullptr)
+				return new Rectangle(D, module);
+			int capacity = held(r);
+			r->fill(D, module);
+			reset(r, capacity);
+			return r;
+		}
+		Rectangle* make(const rect_structure& modules);
+		Rectangle* copy(const Rectangle& r);
+		//One more holder for r
+		Rectangle* share(Rectangle* r){r->refs++; return r;}
+
+		//The rectangles may come from new, they are deleted by clear()
+		//once no holder is left
+		void release(Rectangle* r);
+		//Release a whole partition, R is emptied
+		void release(std::vector<Rectangle*>& R);
+		//Give the released rectangles back to the heap
+		void clear();
+
+		size_t idle() const {return small.size() + large.size();}
+		size_t memory_footprint() const;
+
+	private:
+		//A released rectangle for length ints, nullptr if a new one is needed
+		Rectangle* take(int length);
+		int held(const Rectangle* r) const {return r->length > Rectangle::inline_length ? r->capacity : 0;}
+		void reset(Rectangle* r, int capacity);
+};
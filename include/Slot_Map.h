@@ -0,0 +1,71 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+#include <vector>
+
+#include "Rectangle.h"
+
+// Dense integer ids of the rectangles of the partition. An id is given when
+// a rectangle enters the partition and taken back when it leaves, freed ids
+// are given again first. The ids, unlike the addresses, do not depend on the
+// allocator, so the registers (sets of ids) and the order of R are the same
+// from one run to the next.
+class Slot_Map{
+	std::vector<Rectangle*> slots;	// nullptr for a free id
+	std::vector<int> free_ids;
+
+	public:
+		void insert(Rectangle* r){
+			if(free_ids.empty()){
+				r->id = slots.size();
+				slots.push_back(r);
+			}
+			else{
+				r->id = free_ids.back();
+				free_ids.pop_back();
+				slots[r->id] = r;
+			}
+		}
+		void erase(Rectangle* r){
+			slots[r->id] = nullptr;
+			free_ids.push_back(r->id);
+			r->id = -1;
+		}
+		void clear(){
+			slots.clear();
+			free_ids.clear();
+		}
+
+		Rectangle* operator[](int id) const {return slots[id];}
+		// Every id is below capacity()
+		size_t capacity() const {return slots.size();}
+};
+
+// Order of the rectangles by id, the order in which build_R lists them
+struct By_Id{
+	bool operator()(const Rectangle* a, const Rectangle* b) const {return a->id < b->id;}
+};
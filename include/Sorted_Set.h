@@ -0,0 +1,83 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+// Kernels on sorted arrays of distinct values (modules, brick nodes, registers).
+// The merge kernels compare blocks of 4 (SSE4.1) or 8 (AVX2) values against each
+// other and compact the result with a shuffle. When one side is much smaller,
+// its values are searched in the other side by galloping. The instruction set
+// is detected when the program starts, with a scalar fallback.
+class Sorted_Set{
+	public:
+		//Output buffers must hold min(na, nb) values (na for difference) plus padding,
+		//the blocks are stored whole before the count is known
+		static size_t intersection(const int* a, size_t na, const int* b, size_t nb, int* out);
+		static size_t difference(const int* a, size_t na, const int* b, size_t nb, int* out);
+		static size_t intersection(const uint64_t* a, size_t na, const uint64_t* b, size_t nb, uint64_t* out);
+		//a inter b and a \ b in one pass, the counts are returned in ninter and ndiff
+		static void split(const int* a, size_t na, const int* b, size_t nb, int* inter, size_t& ninter, int* diff, size_t& ndiff);
+		//Positions in a of the values that are also in b
+		static size_t match(const int* a, size_t na, const int* b, size_t nb, int* pos);
+
+		//Sorted vectors of pointers (registers), out is overwritten
+		template <typename T> static void intersection(const std::vector<T*>& a, const std::vector<T*>& b, std::vector<T*>& out){
+			out.resize(std::min(a.size(), b.size()) + padding);
+			out.resize(intersection(reinterpret_cast<const uint64_t*>(a.data()), a.size(),
+				reinterpret_cast<const uint64_t*>(b.data()), b.size(), reinterpret_cast<uint64_t*>(out.data())));
+		}
+
+		// Calls f(i) for every position i in a whose value is also in b.
+		// b is taken by chunks so that the positions fit on the stack.
+		template <typename F> static void for_each_match(const int* a, size_t na, const int* b, size_t nb, F f){
+			int pos[match_chunk + padding];
+			size_t offset = 0;
+			while(na > 0 and nb > 0){
+				size_t nb_chunk = std::min(nb, match_chunk);
+				size_t na_chunk = (nb_chunk < nb) ? std::lower_bound(a, a + na, b[nb_chunk]) - a : na;
+				size_t n = match(a, na_chunk, b, nb_chunk, pos);
+				for(size_t k = 0; k < n; k++)
+					f(offset + pos[k]);
+				a += na_chunk; na -= na_chunk; offset += na_chunk;
+				b += nb_chunk; nb -= nb_chunk;
+			}
+		}
+
+		//Instruction set in use ("avx2", "sse4.1" or "scalar")
+		static std::string isa();
+		//Force an instruction set, returns false if the cpu does not support it
+		static bool use_isa(const std::string& name);
+
+		//Galloping is used when one side is gallop_ratio times smaller
+		static const size_t gallop_ratio = 32;
+		static const size_t match_chunk = 256;
+		static const size_t padding = 8;
+};
@@ -28,10 +28,6 @@
 
 using namespace std;
 
-double Brick::weight = 0;
-double Brick::info = 0;
-int Brick::non_zero = 0;
-rect_structure* Brick::r = nullptr;
 vector<string> Brick::spaces({" "});
 
 Brick::Brick(int d) : dim(d){}
@@ -41,10 +37,10 @@ Brick::~Brick(){}
 
 
 //Processing Rectangle
-void Brick::get_weight(){}
-void Brick::get_info(){}
-void Brick::get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value){}
-void Brick::get_non_zero(Rectangle* R){}
+void Brick::query(Query_Context& q) const{}
+void Brick::fragment_query(Fragment_Context& q, int n) const{}
+void Brick::get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value) const{}
+void Brick::get_cells(std::vector<int>& coords, std::vector<double>& values, std::vector<int>& path){}
 
 //Tree construction
 	//node brick construction
@@ -52,11 +48,15 @@ Brick* Brick::insert_Node_Brick(int dim, int node){}
 	//data brick construction
 Brick* Brick::insert_Data_Brick(int dim, int node){}
 void Brick::insert_value(int node, double value){}
+Brick* Brick::append_Node_Brick(int dim, int node){return nullptr;}
+Brick* Brick::append_Data_Brick(int dim, int node){return nullptr;}
+void Brick::append_value(int node, double value){}
 void Brick::normalize(double Eg){}
 
 //print
 void Brick::print_bricks(){}
 void Brick::print_data_on_file(std::ofstream& datafile, int N){}
-void Brick::make_micro(std::vector<Rectangle*>& R, rect_structure* rect){}
+size_t Brick::memory_footprint(){return 0;}
+void Brick::make_micro(std::vector<Rectangle*>& R, rect_structure* rect, Rectangle_Pool& pool){}
 //void Brick::atomise(Rectangle* ref_rect, std::vector<Rectangle*>& new_Rs){}
-void Brick::shrink(rect_structure* rect){}
\ No newline at end of file
+void Brick::shrink(const Rectangle& r, std::vector<std::vector<int>>& found) const{}
\ No newline at end of file
@@ -29,17 +29,17 @@ using namespace std;
 
 
 //Create a Builder Object and  build a Random Matrix Model
-Builder::Builder(vector<int> N, vector<double> params) : N(N), D(N.size()){
-	data_tool = new Generater(N, params);
+Builder::Builder(vector<int> N, vector<double> params, string layout) : N(N), D(N.size()){
+	data_tool = new Generater(N, params, layout);
 	E = data_tool->E;
 	Ew = data_tool->Ew;
 	log_E = log2((double)E);
 }
 
 //Create a Builder Object and load a Graph from a csv or a json file
-Builder::Builder(string input_filename){
+Builder::Builder(string input_filename, string layout){
 	cout << "Builder Reader constructor" << endl;
-	data_tool = new Reader(input_filename);
+	data_tool = new Reader(input_filename, layout);
 	cout << "reader done" << endl;
 	N = data_tool->N;
 	D = N.size();
@@ -50,9 +50,9 @@ Builder::Builder(string input_filename){
 }
 
 //Create a Builder Object with a Benchmark Graph of scale n
-Builder::Builder(string type, int n){
+Builder::Builder(string type, int n, string layout){
 	//cout << "Builder Generater constructor" << endl;
-	data_tool = new Generater(type, n);
+	data_tool = new Generater(type, n, layout);
 	N = data_tool->N;
 	D = data_tool->D;
 	E = data_tool->E;
@@ -64,6 +64,15 @@ Builder::Builder(string type, int n){
 Builder::Builder(vector<int> N): N(N), D(N.size()), E(0), Ew(0), data_tool(nullptr){
 }
 
+//Create a Builder Object over the data of another one, which keeps it
+Builder::Builder(Data_Tree* shared_data): data_tool(shared_data), owns_data(false){
+	N = data_tool->N;
+	D = N.size();
+	E = data_tool->E;
+	Ew = data_tool->Ew;
+	log_E = log2((double)E);
+}
+
 //Create a Builder Object
 Builder::Builder(): D(0), N(vector<int>(0)), E(0), Ew(0), data_tool(nullptr){
 }
@@ -74,88 +83,108 @@ Builder::~Builder(){
 	//R.clear();
 	//if(reg.size() > 0)
 	//	build_R(R);
-	if(R.size() > 0)
-		for (int i = 0; i < R.size(); i++)
-		    delete R[i];
-	R.clear();
+	pool.release(R);
 
 	//Clean data
-	if(data_tool != nullptr)
+	if(data_tool != nullptr and owns_data)
 		delete data_tool;
 }
 
 //Build a macro partition
 void Builder::macro(){
-	rect_structure* rect = new rect_structure(D);
-	for(int d = 0; d < D; d++)
-    	(*rect)[d] = make_shared<vector<int>>(); //intersection
-
+	rect_structure rect;
 	for(int d = 0; d < D; d++){
-		(*rect)[d]->resize(N[d]);
-		iota((*rect)[d]->begin(), (*rect)[d]->end(), 0);
+		vector<int> nodes(N[d]);
+		iota(nodes.begin(), nodes.end(), 0);
+		rect.emplace_back(move(nodes));
 	}
-	Rectangle* r = new Rectangle(rect);
-	R.push_back(r);
+	insert_R(pool.make(rect));
 	Rsize = 1;
 	starting_partition = "macro ";
 }
 
 //Build a micro partition by using the data
 void Builder::micro(){
-	data_tool->make_micro(R);
+	data_tool->make_micro(R, pool);
 	Rsize = R.size();
-	sort(R.begin(), R.end());
+	for(Rectangle* r : R)
+		slot_map.insert(r);
+	index_R();
 	starting_partition = "micro ";
 }
 
+//Build a partition with copies of the rectangles of another partition,
+//which may belong to another object
+void Builder::start_from(const vector<Rectangle*>& partition){
+	for(const Rectangle* r : partition)
+		insert_R(pool.copy(*r));
+	Rsize = R.size();
+	starting_partition = "warm ";
+}
+
 //Rebuild the partition using the registers
 void Builder::build_R(){
-	R.clear();
-	for (auto it = reg[0].begin(); it != reg[0].end(); ++it){
-        buffer.clear();
-        set_union(R.begin(), R.end(), it->begin(), it->end(),
-        back_inserter(buffer));
-
-        swap(R, buffer);
-	}
-	sort(R.begin(), R.end());
-	R.erase(unique(R.begin(), R.end()), R.end());
+	build_R(R);
+	index_R();
 }
 
 //Rebuild the partition using the register and put it in a vector passed by reference
 void Builder::build_R(vector<Rectangle*>& R){
-	R.clear();
-
-	for (auto it = reg[0].begin(); it != reg[0].end(); ++it){
-        buffer.clear();
-        set_union(R.begin(), R.end(), it->begin(), it->end(),
-        back_inserter(buffer));
+	patch_registers();
+	ids_of_registers(reg[0], R);
+}
 
-        swap(R, buffer);
-	}
-	sort(R.begin(), R.end());
-	R.erase(unique(R.begin(), R.end()), R.end());
+//Rectangles of the ids found in some registers, in the order of the ids
+void Builder::ids_of_registers(const vector<Id_Set>& registers, vector<Rectangle*>& R){
+	vector<uint64_t> words((slot_map.capacity() + 63)/64, 0);
+	for(const Id_Set& s : registers)
+		s.or_into(words.data(), words.size());
+	R.clear();
+	for(size_t w = 0; w < words.size(); w++)
+		for(uint64_t word = words[w]; word; word &= word - 1)
+			R.push_back(slot_map[w*64 + __builtin_ctzll(word)]);
 }
 
-//Clean up the partition
+//Clean up the partition, its rectangles go back to the pool
 void Builder::clean_R(){
-	if(R.size() > 0)
-		for (int i = 0; i < R.size(); ++i)
-		    delete R[i];
-	R.clear();
+	slot_map.clear();
+	R_index.clear();
+	pool.release(R);
 }
 
 //Clean up a partition given by reference
 void Builder::clean_R(vector<Rectangle*>& R){
-	if(R.size() > 0){
-		//cout << "Cleaning partition of size " << R.size() << endl;
-		for (int i = 0; i < R.size(); ++i){
-			//cout << "Cleaning number " << i << endl;
-		    //cout << "Adress " << R[i] << endl;
-		    delete R[i];
-		}
-	}
-	R.clear();
+	pool.release(R);
+}
+
+//Give an id to a rectangle and add it at the end of R
+void Builder::insert_R(Rectangle* r){
+	slot_map.insert(r);
+	if(R_index.size() < slot_map.capacity())
+		R_index.resize(slot_map.capacity());
+	R_index[r->id] = R.size();
+	R.push_back(r);
+}
+
+//Remove a rectangle from R by moving the last one in its place, and take back its id
+void Builder::erase_R(Rectangle* r){
+	int i = R_index[r->id];
+	R[i] = R.back();
+	R_index[R[i]->id] = i;
+	R.pop_back();
+	slot_map.erase(r);
+}
+
+//True if r is in the partition of this object
+bool Builder::is_live(const Rectangle* r) const{
+	return r->id >= 0 and r->id < slot_map.capacity() and slot_map[r->id] == r;
+}
+
+//Positions of the rectangles of R, after R was filled directly
+void Builder::index_R(){
+	R_index.assign(slot_map.capacity(), -1);
+	for(int i = 0; i < R.size(); i++)
+		R_index[R[i]->id] = i;
 }
 
 //Build the registers
@@ -165,6 +194,7 @@ void Builder::reg_of_R(){
 	//cout << "reg.size() " << reg.size() << endl;
 	for(int d = 0; d < D; d++)
 		reg[d].resize(N[d]);
+	clear_register_edits();
 
 	//iterate over rectangles : index over R
 	for(Rectangle* r : R){
@@ -173,8 +203,8 @@ void Builder::reg_of_R(){
 			for(int d = 0; d < D; d++){
 				//iterate over module of current dimension
 				for(int n : (*r)[d]){
-					//Append to register of node N in dimension d the index of the rectangle
-					reg[d][n].push_back(r);
+					//Append to register of node N in dimension d the id of the rectangle
+					reg[d][n].insert(r->id);
 				}
 			}
 		}
@@ -187,28 +217,95 @@ void Builder::clean_registers(){
 	    for(int d = 0; d < D; d++)
     	    for(int i = 0; i < N[d]; i++)
         	    reg[d][i].clear();
+	clear_register_edits();
+}
+
+//Add an edit to the batch, the register of the node is dirty until the next patch_registers
+void Builder::edit_register(int d, int node, int id, bool insert){
+	register_edits[d].push_back({node, id, int(register_edits[d].size()), insert});
+	dirty_nodes[d][node] = 1;
+}
+
+//Add the edits of all the registers of a rectangle to the batch
+void Builder::edit_registers(Rectangle* r, bool insert){
+	for(int d = 0; d < D; d++)
+		for(int node : (*r)[d])
+			edit_register(d, node, r->id, insert);
 }
 
-//Returns a copy of the partition
+//Apply the batch, each dirty register is patched once. Only the last
+//edit of an id counts, since an id freed in the batch can be given again.
+void Builder::patch_registers(){
+	for(int d = 0; d < register_edits.size(); d++){
+		vector<Register_Edit>& edits = register_edits[d];
+		sort(edits.begin(), edits.end());
+		for(size_t i = 0; i < edits.size();){
+			int node = edits[i].node;
+			patch_del.clear();
+			patch_add.clear();
+			for(; i < edits.size() and edits[i].node == node; i++){
+				if(i + 1 < edits.size() and edits[i+1].node == node and edits[i+1].id == edits[i].id)
+					continue;
+				(edits[i].insert ? patch_add : patch_del).push_back(edits[i].id);
+			}
+			reg[d][node].patch(patch_del, patch_add);
+			dirty_nodes[d][node] = 0;
+		}
+		edits.clear();
+	}
+}
+
+//Forget the batch, when the registers are rebuilt
+void Builder::clear_register_edits(){
+	register_edits.assign(D, {});
+	dirty_nodes.resize(D);
+	for(int d = 0; d < D; d++)
+		dirty_nodes[d].assign(N[d], 0);
+}
+
+size_t Builder::register_edits_size() const{
+	size_t size = 0;
+	for(const vector<Register_Edit>& edits : register_edits)
+		size += edits.size();
+	return size;
+}
+
+//Returns a snapshot of the partition. The rectangles are shared, not copied,
+//the later operations replace them without modifying them.
 vector<Rectangle*>* Builder::copy_partition(){
 	std::vector<Rectangle*>* R_copy = new std::vector<Rectangle*>;
-	for(auto r : R){
-		//rect_structure* rect = new rect_structure(r->rectangle);
-		Rectangle* r_copy = new Rectangle(*r);
-		R_copy->push_back(r_copy);
-	}
-	sort(R_copy->begin(), R_copy->end());
+	R_copy->reserve(R.size());
+	for(auto r : R)
+		R_copy->push_back(pool.share(r));
 	return R_copy;
 }
 
-//Copy a partition in the object's dedicated memory for the partition
-//Cleaning the object's dedicated memory for the partition is not managed here.
+//Make the partition equal to a snapshot by replaying the difference. The
+//rectangles held by both stay in place, the others leave or enter the
+//partition and, if they are built, the registers through the batch.
 void Builder::copy_partition(vector<Rectangle*>* R_copy){
-	for(auto r_copy : *R_copy){
-		Rectangle* r = new Rectangle(*r_copy);
-		R.push_back(r);
+	bool registers = reg.size() == D;
+	vector<char> kept(slot_map.capacity(), 0);
+	for(Rectangle* r : *R_copy)
+		if(is_live(r))
+			kept[r->id] = 1;
+	//Erasing R[i] moves a rectangle already visited in its place
+	for(int i = int(R.size()) - 1; i >= 0; i--){
+		Rectangle* r = R[i];
+		if(kept[r->id])
+			continue;
+		if(registers)
+			edit_registers(r, false);
+		erase_R(r);
+		pool.release(r);
+	}
+	for(Rectangle* r : *R_copy){
+		if(is_live(r))
+			continue;
+		insert_R(pool.share(r));
+		if(registers)
+			edit_registers(r, true);
 	}
-	sort(R.begin(), R.end());
 }
 
 //Print all the rectangles of the partition
@@ -216,7 +313,7 @@ void Builder::print_R(){
 	cout << "***Printing partition : " << endl;
 	for (const Rectangle* r : R){
 		if(r != nullptr){
-			cout << "Rectangle : " << r << " components : " << r->rectangle << "  with " << r->rectangle->size() << " dimensions" << endl;
+			cout << "Rectangle : " << r << "  with " << r->dimensions() << " dimensions" << endl;
 	    	cout << "Sizes are : ";
 			for(int d = 0; d < D; d++){
 	    		cout << (*r)[d].size() << "   ";
@@ -233,7 +330,7 @@ void Builder::print_R(vector<Rectangle*>& R){
 	cout << "***Printing supplied partition : " << endl;
 	for (const Rectangle* r : R){
 		if(r != nullptr){
-			cout << "Rectangle : " << r << " components : " << r->rectangle << "  with " << r->rectangle->size() << " dimensions" << endl;
+			cout << "Rectangle : " << r << "  with " << r->dimensions() << " dimensions" << endl;
 	    	cout << "Sizes are : ";
 			for(int d = 0; d < D; d++){
 	    		cout << (*r)[d].size() << "   ";
@@ -248,6 +345,7 @@ void Builder::print_R(vector<Rectangle*>& R){
 //Print the size of the registers
 void Builder::print_reg_size(){
 	cout << endl << "***Registers size : " << endl;
+	patch_registers();
 	for(int d = 0; d < D; d++){
 		for(int i = 0; i < reg[d].size(); i++){
 			cout << "Register dimension " << d << " line : " << i << " size : " << reg[d][i].size() << endl;
@@ -258,13 +356,14 @@ void Builder::print_reg_size(){
 //Print the registers
 void Builder::print_reg(){
 	cout << endl << "***Printing registers" << endl;
+	patch_registers();
 	for(int d = 0; d < D; d++){
 		cout << "Register dimension " << d << " size : " << reg[d].size() << endl;
 		for(int i = 0; i < reg[d].size(); i++){
 			cout << "line " << i << "   ";
-			for(auto const &e : reg[d][i]){
-				cout << e << " ";
-			}
+			reg[d][i].for_each([](int id){
+				cout << id << " ";
+			});
 			cout << endl;
 		}
 		cout << endl;
@@ -273,8 +372,8 @@ void Builder::print_reg(){
 
 //Print the rectangle in a Rectangle Object
 void Builder::print_rectangle(const Rectangle* r){
-	for(auto const& m : *(r->rectangle)){
-		print(*m);
+	for(int d = 0; d < r->dimensions(); d++){
+		print((*r)[d]);
 	}
 }
 
@@ -282,13 +381,13 @@ void Builder::print_rectangle(const Rectangle* r){
 void Builder::print_rectangle_full(const Rectangle* r){
 	cout << "Printing : " << endl;
 	cout << "Adress : " << r << endl;
-	cout << "rect adress : " << r->rectangle << endl;
+	cout << "Bytes : " << r->memory_footprint() << endl;
 	cout << "Modules adresses : " << endl;
 	for(int d = 0; d < D; d++){
-		cout << "	module " << d << " : " << (*(r->rectangle))[d] << endl;
+		cout << "	module " << d << " : " << (*r)[d].data() << endl;
 	}
-	for(auto const& m : *(r->rectangle)){
-		print(*m);
+	for(int d = 0; d < r->dimensions(); d++){
+		print((*r)[d]);
 	}
 }
 
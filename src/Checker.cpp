@@ -28,17 +28,17 @@
 using namespace std;
 
 //Constructor for Checker with Data from a Random Matrix Model
-Checker::Checker(vector<int> N, vector<double> params) : Builder(N, params){
+Checker::Checker(vector<int> N, vector<double> params, string layout) : Builder(N, params, layout){
 	init();
 }
 
 //Constructor for Checker with Data imported from a file
-Checker::Checker(string input_filename) : Builder(input_filename){
+Checker::Checker(string input_filename, string layout) : Builder(input_filename, layout){
 	init();
 }
 
 //Constructor for Checker with Benchmark Data
-Checker::Checker(string type, int n) : Builder(type, n){
+Checker::Checker(string type, int n, string layout) : Builder(type, n, layout){
 	init();
 }
 
@@ -47,6 +47,11 @@ Checker::Checker(std::vector<int> N) : Builder(N){
 	init();
 }
 
+//Constructor for Checker over shared data
+Checker::Checker(Data_Tree* shared_data) : Builder(shared_data){
+	init();
+}
+
 //Default Constructor
 Checker::Checker(){}
 
@@ -90,16 +95,24 @@ int Checker::check_all(){
 	return 1;
 }
 
-//Compare R and R_check. R_check must be built with build_R()
+//Compare R and R_check. R_check must be built with build_R(), in the order of the ids
 int Checker::content_of_partition(){
 	cout << "***Checking content of partition vector" << endl;
 	correct = 0;
+	for(int i = 0; i < R.size(); i++){
+		if(R[i]->id < 0 or R[i]->id >= R_index.size() or R_index[R[i]->id] != i){
+			cout << " BAD - Wrong position of rectangle " << R[i] << " in R_index" << endl;
+			correct = 1;
+		}
+	}
+	vector<Rectangle*> R_sorted(R);
+	sort(R_sorted.begin(), R_sorted.end(), By_Id());
 	if(R.size() != R_check.size()){
 		cout << " BAD - Sizes of vectors R and R_check are not equal" << endl;
 		correct = 1;
 	}
 	else{
-		if(!equal(R.begin(), R.end(), R_check.begin())){
+		if(!equal(R_sorted.begin(), R_sorted.end(), R_check.begin())){
 			cout << "BAD - Content of partitions vectors differs" << endl;
 			cout << "R : " << endl;
 			print(R);
@@ -124,16 +137,16 @@ int Checker::content_of_rectangles(){
 	correct = 0;
 	for(Rectangle* r : R){
 		if(r != nullptr){
-			if((*r->rectangle).size() != D){
+			if(r->dimensions() != D){
 				cout << "BAD - Wrong size of rectangle in " << r << endl;
-				cout << "(*r->rectangle).size()  " << (*r->rectangle).size() << "  expected " << D << endl;
+				cout << "r->dimensions()  " << r->dimensions() << "  expected " << D << endl;
 				correct = 1;
 				break;
 			}
 			else{
 				for(int d = 0; d < D; d++){
-					if((*r->rectangle)[d] == nullptr){
-						cout << "nullptr in rectangle  " << r << "   on dim " << d << endl;
+					if((*r)[d].empty()){
+						cout << "empty module in rectangle  " << r << "   on dim " << d << endl;
 						correct = 1;
 					}
 				}
@@ -168,7 +181,7 @@ int Checker::constraints_on_partition(){
 		if(r != nullptr){
 			// Set an iterator at the begining of each dimension of the rectangle
 			for(int d = 0; d < D; d++){
-				rect_it[d] = (*r->rectangle)[d]->begin();
+				rect_it[d] = (*r)[d].begin();
 			}
 			// Iterate over cells
 			for(int i = 0; i < r->size; i++){
@@ -179,12 +192,12 @@ int Checker::constraints_on_partition(){
 				}
 				// Move forward the iterators
 				for(int d = 0; d < D; d++){
-					if(rect_it[d] != (*r->rectangle)[d]->end()-1){
+					if(rect_it[d] != (*r)[d].end()-1){
 						rect_it[d]++;
 						break;
 					}
 					else {
-						rect_it[d] = (*r->rectangle)[d]->begin();
+						rect_it[d] = (*r)[d].begin();
 					}
 				}
 				cells.push_back(n_id);
@@ -225,17 +238,23 @@ int Checker::constraints_on_partition(){
 
 }
 
-//Verifies that the registers are sorted
+//Verifies that the registers are well formed and only hold ids of live rectangles
 int Checker::order_in_registers(){
 	cout << "***Check order in registers"  << endl;
 	correct = 0;
 	for(int d = 0; d < D; d++){
 		for(int n = 0; n < N[d]; n++){
-			if(!is_sorted(reg[d][n].begin(), reg[d][n].end())){
-				cout << "Register not sorted on dim " << d << " line " << n << endl;
-				print(reg[d][n]);
+			if(!reg[d][n].is_valid()){
+				cout << "Register not well formed on dim " << d << " line " << n << endl;
+				print(reg[d][n].ids());
 				correct = 1;
 			}
+			reg[d][n].for_each([&](int id){
+				if(id >= slot_map.capacity() or slot_map[id] == nullptr or slot_map[id]->id != id){
+					cout << "Register on dim " << d << " line " << n << " holds the free id " << id << endl;
+					correct = 1;
+				}
+			});
 		}
 	}
 	if(correct == 0){
@@ -298,15 +317,13 @@ int Checker::rectangles_in_registers(){
 	//Compare registers
 	for(int d = 0; d < D; d++){
 		for(int n = 0; n < N[d]; n++){
-			sort(reg[d][n].begin(), reg[d][n].end());
-			sort(reg_copy[d][n].begin(), reg_copy[d][n].end());
 			if(reg[d][n] != reg_copy[d][n]){
 				cout << "Incorrect registers" << endl;
 				cout << "	Dimension " << d << ", numero " << n << endl;
 				cout << "	Fresh register : " << endl;
-				print(reg[d][n]);
+				print(reg[d][n].ids());
 				cout << "	Updated register : " << endl;
-				print(reg_copy[d][n]);
+				print(reg_copy[d][n].ids());
 				correct = 1;
 			}
 		}
@@ -336,16 +353,12 @@ int Checker::calculated_size_of_partition(){
 
 //Convenient function for calculating intersection of multiples registers 
 int Checker::intersect(regit const& vecs){
-    vector<Rectangle*> result;
-    set_intersection(vecs[0]->begin(), vecs[0]->end(), vecs[1]->begin(), vecs[1]->end(), back_inserter(result));
-    if (vecs.size() == 2) 
-    	return result.size();
-
-    vector<Rectangle*> buffer;
-    for (int i = 2; i < vecs.size(); ++i){
-        buffer.clear();
-        set_intersection(result.begin(), result.end(), vecs[i]->begin(), vecs[i]->end(), back_inserter(buffer));
-        swap(result, buffer);
-    }
-    return result.size();
+    int result = 0;
+    vecs[0]->for_each([&](int id){
+        for(int i = 1; i < vecs.size(); ++i)
+            if(!vecs[i]->contains(id))
+                return;
+        result++;
+    });
+    return result;
 }
\ No newline at end of file
@@ -31,22 +31,22 @@ using namespace std::chrono;
 
 // Constructor for Compressor with Data from a Random Matrix Model
 Compressor::Compressor(vector<int> N, vector<double> params, double lambda,
-                        double gap, int nsearch):
-						Optimizer(N, params, lambda),
+                        double gap, int nsearch, string layout):
+						Optimizer(N, params, lambda, layout),
 						gap(gap), nsearch(nsearch){
 }
 
 // Constructor for Compressor with Data imported from a file
 Compressor::Compressor(string input_filename, double lambda,
-						double gap, int nsearch):
-						Optimizer(input_filename, lambda),
+						double gap, int nsearch, string layout):
+						Optimizer(input_filename, lambda, layout),
 						gap(gap), nsearch(nsearch){
 }
 
 // Constructor for Compressor with Benchmark Data
 Compressor::Compressor(string type, int n, double lambda,
-						double gap, int nsearch):
-						Optimizer(type, n, lambda),
+						double gap, int nsearch, string layout):
+						Optimizer(type, n, lambda, layout),
 						gap(gap), nsearch(nsearch){
 }
 
@@ -87,7 +87,9 @@ void Compressor::dichotomic_search(){
 	cout << "micro size : " << get<2>(*low_explo)->size() << " adress : " << get<2>(*low_explo) << endl;
 	cout << "macro size : " << get<2>(*up_explo)->size() << " adress : " << get<2>(*up_explo) << endl;
 
-	do{
+	if(nthreads > 1)
+		parallel_sweep();
+	else do{
 		d_lambda = get<0>(*up_explo) - get<0>(*low_explo);
 		if(get<2>(*low_explo) != get<2>(*up_explo) and d_lambda > gap){
 			lambda = get<0>(*low_explo) + d_lambda/2;
@@ -112,6 +114,58 @@ void Compressor::dichotomic_search(){
     write_partitions(homogeneous_solutions);
     free_memory(explored_lambda);
     print_to_print();
+    print_envelope();
+}
+
+// The compression scale from one trajectory. The optimizer goes from micro
+// to macro, steered by a lambda halved from 100 to gap and then 0, and keeps
+// in its Pareto archive every partition it visits that is not dominated.
+// The partitions of the lower envelope of the archive are written.
+void Compressor::pareto_search(){
+    data_tool->print_data_on_file(generated_data_filename);
+    t_start = steady_clock::now();
+    clear_archive();
+    archiving = true;
+
+	//MACRO
+	clean_optimization_program();
+	lambda = 0.0;
+	macro();
+	reg_of_R();
+	initialize_objective();
+	archive_partition();
+
+	//MICRO, the start of the trajectory
+	clean_optimization_program();
+	lambda = 100.0;
+	micro();
+	reg_of_R();
+	initialize_objective();
+	archive_partition();
+
+	while(true){
+		cout << "Steering lambda : " << lambda << endl;
+		ndiv_limit = ndiv_start;
+		mix_program_succinct();
+		clean_R(*get<2>(best_solution));
+		if(lambda == 0)
+			break;
+		lambda = lambda/2 < gap ? 0.0 : lambda/2;
+	}
+	archiving = false;
+	algorithm = "pareto search";
+
+	vector<storage> front;
+	for(auto& p : pareto)
+		front.push_back(p.second);
+	lower_envelope(front);
+
+    t_stop = steady_clock::now();
+    optim_time = duration_cast<duration<double>>(t_stop - t_start);
+    write_partitions(envelope);
+    write_archive();
+    print_envelope();
+    clear_archive();
 }
 
 // A Dichotomic Search Without tests
@@ -168,35 +222,190 @@ void Compressor::dichotomic_search_no_check(){
 }
 
 // The Otpimization program. It runs several mix program and
-// keeps the best solution found
+// keeps the best solution found. The restarts are independent, each has
+// its own seed, so with nthreads > 1 they run on Optimizers sharing the
+// data of this object and the best one is kept, as it would be in order.
 void Compressor::optimization_program(){
+	restart_seeds.clear();
+	for(int s = 0; s < nsearch; s++)
+		restart_seeds.push_back(eng());
+	vector<Rectangle*>* start = warm_partition(low_explo, lambda);
+
+	if(nthreads <= 1){
+		restart(*this, restart_seeds[0], start);
+		optim_trials = best_solution;
+
+		for(int s = 1; s < nsearch; s++){
+			restart(*this, restart_seeds[s], start);
+
+			if(cost < get<1>(optim_trials)){
+				clean_R(*get<2>(optim_trials));
+				optim_trials = best_solution;
+			}
+			else{
+				clean_R();
+			}
+		}
+		return;
+	}
+
+	vector<storage> trials(1);
+	get<0>(trials[0]) = lambda;
+	get<2>(trials[0]) = start;
+	run_restarts(trials);
+	optim_trials = trials[0];
+
+	//Leave the best partition in this object, as the sequential run does
 	clean_optimization_program();
-	micro();
+	copy_partition(get<2>(optim_trials));
 	reg_of_R();
-	mix_program_succinct();
-	optim_trials = best_solution;
+	cost    = get<1>(optim_trials);
+	Rsize   = get<3>(optim_trials);
+	info    = get<4>(optim_trials);
+	loss    = get<5>(optim_trials);
+	dkl     = get<6>(optim_trials);
+	ldkl    = get<7>(optim_trials);
+	penalty = get<8>(optim_trials);
+}
 
-	for(int s = 1; s < nsearch; s++){
-		clean_optimization_program();
-		micro();
-		reg_of_R();
-		mix_program_succinct();
+// Run the nsearch restarts of each lambda of trials on nthreads workers
+// sharing the data of this object. Restart s of trial i takes the seed
+// restart_seeds[i*nsearch + s] and starts from the partition of the trial,
+// micro if it is nullptr. Each trial gets the best solution of its
+// restarts, the first one in case of a tie.
+void Compressor::run_restarts(vector<storage>& trials){
+	int n_tasks = trials.size()*nsearch;
+	vector<storage> solutions(n_tasks);
+	atomic<int> next(0);
+	auto worker = [&](){
+		Optimizer G(data_tool, lambda);
+		G.set_parameters(nfail_limit, ndiv_start, ndiv_increm, ncycle);
+		G.binomial_p = binomial_p;
+		G.register_batch_max = register_batch_max;
+		for(int task = next++; task < n_tasks; task = next++){
+			G.lambda = get<0>(trials[task/nsearch]);
+			restart(G, restart_seeds[task], get<2>(trials[task/nsearch]));
+			solutions[task] = G.best_solution;
+		}
+	};
+	vector<thread> threads;
+	for(int t = 0; t < min(nthreads, n_tasks); t++)
+		threads.emplace_back(worker);
+	for(thread& t : threads)
+		t.join();
+
+	//The rectangles of the solutions outlive the workers, this object takes them
+	for(int i = 0; i < trials.size(); i++){
+		trials[i] = solutions[i*nsearch];
+		for(int s = 1; s < nsearch; s++){
+			storage& S = solutions[i*nsearch + s];
+			if(get<1>(S) < get<1>(trials[i])){
+				clean_R(*get<2>(trials[i]));
+				trials[i] = S;
+			}
+			else
+				clean_R(*get<2>(S));
+		}
+	}
+}
+
+// One restart of the optimization program on G, from the micro partition
+// or from copies of the rectangles of start, divided warm_perturbation
+// times at random
+void Compressor::restart(Optimizer& G, unsigned seed, vector<Rectangle*>* start){
+	G.clean_registers();
+	G.clean_R();
+	G.seed(seed);
+	G.ndiv_limit = G.ndiv_start;
+	if(start == nullptr){
+		G.micro();
+		G.reg_of_R();
+	}
+	else{
+		G.start_from(*start);
+		G.reg_of_R();
+		for(int i = 0; i < warm_perturbation; i++)
+			if(G.find_division())
+				G.doCluster();
+	}
+	G.mix_program_succinct();
+}
 
-		if(cost < get<1>(optim_trials)){
-			clean_R(*get<2>(optim_trials));
-			optim_trials = best_solution;
+// The partition of the interval from low to its successor with the lower
+// cost at lambda l, nullptr to start from micro
+vector<Rectangle*>* Compressor::warm_partition(vector<storage>::iterator low, double l){
+	if(!warm_start or next(low) == explored_lambda.end())
+		return nullptr;
+	return cost_at(*low, l) <= cost_at(*next(low), l) ? get<2>(*low) : get<2>(*next(low));
+}
+
+// The loop of dichotomic_search with nthreads workers. The frontier holds the
+// intervals of explored_lambda still to split, by their lower lambda. Up to
+// nthreads of them are split at once, then their midpoints are checked in
+// lambda order as the loop would do. After a check, the sequential loop would
+// go on from the new (low_explo, up_explo) to the former upper end, so these
+// intervals join the frontier. An interval closed by the check of its left
+// neighbour is dropped with its midpoint.
+void Compressor::parallel_sweep(){
+	auto lower = [&](double l){
+		return lower_bound(explored_lambda.begin(), explored_lambda.end(), l,
+			[](const storage& S, double l){return get<0>(S) < l;});
+	};
+	auto open = [&](vector<storage>::iterator low){
+		return next(low) != explored_lambda.end() and get<2>(*low) != get<2>(*next(low))
+			and get<0>(*next(low)) - get<0>(*low) > gap;
+	};
+
+	set<double> frontier = {get<0>(explored_lambda.front())};
+	vector<pair<double, double>> intervals;
+	vector<storage> trials;
+	while(!frontier.empty()){
+		intervals.clear();
+		for(auto l = frontier.begin(); l != frontier.end() and intervals.size() < nthreads;){
+			auto low = lower(*l);
+			if(!open(low)){
+				l = frontier.erase(l);
+				continue;
+			}
+			intervals.push_back({*l, get<0>(*next(low))});
+			l++;
 		}
-		else{
-			clean_R();
+		if(intervals.empty())
+			break;
+
+		trials.assign(intervals.size(), storage());
+		restart_seeds.clear();
+		for(int i = 0; i < intervals.size(); i++){
+			get<0>(trials[i]) = (intervals[i].first + intervals[i].second)/2;
+			get<2>(trials[i]) = warm_partition(lower(intervals[i].first), get<0>(trials[i]));
+			for(int s = 0; s < nsearch; s++)
+				restart_seeds.push_back(eng());
+		}
+		run_restarts(trials);
+
+		for(int i = 0; i < intervals.size(); i++){
+			frontier.erase(intervals[i].first);
+			low_explo = lower(intervals[i].first);
+			if(!open(low_explo) or get<0>(*next(low_explo)) != intervals[i].second){
+				clean_R(*get<2>(trials[i]));
+				continue;
+			}
+			up_explo = next(low_explo);
+			lambda = get<0>(trials[i]);
+			optim_trials = trials[i];
+			full_check_solution_dichotomic_search();
+			for(auto it = low_explo; it != explored_lambda.end() and get<0>(*it) < intervals[i].second; it++)
+				frontier.insert(get<0>(*it));
 		}
 	}
+	low_explo = explored_lambda.end()-1;
+	up_explo = explored_lambda.end();
 }
 
 // Cleans the object. It allows to rebuild entirely a new partition
 // and its registers
 void Compressor::clean_optimization_program(){
 	clean_registers();
-	clean_temp_registers();
 	clean_R();
 }
 
@@ -366,43 +575,82 @@ void Compressor::full_check_solution_dichotomic_search(){
 }
 
 
-// Remove duplicate partitions from explored_lambda
+// Set the objective of the object to the one of the partition cached in S,
+// at the current lambda. The cost of a partition is linear in lambda, so
+// (dkl, Rsize) is enough and no rectangle is queried.
+void Compressor::evaluate(const storage& S){
+	Rsize = get<3>(S);
+	info = get<4>(S);
+	loss = get<5>(S);
+	dkl = get<6>(S);
+	dkl_factor = lambda/Ew;
+	ldkl = dkl_factor*dkl;
+	penalty = penalty_factor*Rsize;
+	cost = ldkl + penalty;
+}
+
+// Cost of the partition cached in S for a given lambda
+double Compressor::cost_at(const storage& S, double l){
+	return l/Ew*get<6>(S) + penalty_factor*get<3>(S);
+}
+
+// Lambda at which the partitions cached in a and b have the same cost
+double Compressor::crossing(const storage& a, const storage& b){
+	return Ew*penalty_factor*(get<3>(b) - get<3>(a))/(get<6>(a) - get<6>(b));
+}
+
+// Lower envelope of the costs of some partitions over lambda >= 0.
+// The partitions are lines of slope dkl/Ew, taken from the steepest one,
+// which is the best at lambda = 0. envelope[i] is the best partition from
+// breakpoints[i-1] (or 0) to breakpoints[i] (or infinity).
+void Compressor::lower_envelope(vector<storage> lines){
+	sort(lines.begin(), lines.end(), [](const storage& a, const storage& b){
+		if(get<6>(a) != get<6>(b))
+			return get<6>(a) > get<6>(b);
+		return get<3>(a) < get<3>(b);
+	});
+
+	envelope.clear();
+	breakpoints.clear();
+	for(auto& l : lines){
+		//Same slope, the one already taken is not worse
+		if(!envelope.empty() and get<6>(envelope.back()) == get<6>(l))
+			continue;
+		//Drop the partitions that l beats wherever they were the best
+		while(!envelope.empty() and
+			  crossing(envelope.back(), l) <= (breakpoints.empty() ? 0.0 : breakpoints.back())){
+			envelope.pop_back();
+			if(!breakpoints.empty())
+				breakpoints.pop_back();
+		}
+		if(!envelope.empty())
+			breakpoints.push_back(crossing(envelope.back(), l));
+		envelope.push_back(l);
+	}
+
+	//Each partition of the envelope is stored at the lambda where it becomes the best
+	for(int i = 0; i < envelope.size(); i++){
+		lambda = i == 0 ? 0.0 : breakpoints[i-1];
+		evaluate(envelope[i]);
+		get<0>(envelope[i]) = lambda;
+		update_storage(envelope[i]);
+	}
+}
+
+// Give to each explored lambda the best explored partition,
+// read on the lower envelope
 void Compressor::make_homogeneous(){
+	lower_envelope(explored_lambda);
 	homogeneous_solutions = explored_lambda;
-	c_explo = explored_lambda.begin();
-	h_explo = homogeneous_solutions.begin();
-
-    while(c_explo != explored_lambda.end()){
-    	//gather all candidate partitions
-    	partitions.clear();
-    	if(c_explo != explored_lambda.begin()){
-    		partitions.push_back(get<2>(*prev(c_explo)));
-    		partitions.push_back(get<2>(*prev(h_explo)));
-    	}
-    	if(c_explo != explored_lambda.end()-1){
-    		partitions.push_back(get<2>(*next(c_explo)));
-    		partitions.push_back(get<2>(*next(h_explo)));
-    	}
-
-    	//Sort and remove duplicate
-    	vector<vector<Rectangle*>*>::iterator it = remove(partitions.begin(), partitions.end(), get<2>(*h_explo));
-    	partitions.resize(distance(partitions.begin(), it));
-
-    	sort(partitions.begin(), partitions.end());
-    	partitions.erase(unique(partitions.begin(), partitions.end()), partitions.end());
-
-    	//Test all on h_explo lambda's
-    	lambda = get<0>(*h_explo);
-    	for(auto p : partitions){
-    		get_objective(*p);
-			if(cost < get<1>(*h_explo)){
-				update_storage(*h_explo);
-				get<2>(*h_explo) = p;
-			}
+	for(auto& h : homogeneous_solutions){
+		lambda = get<0>(h);
+		storage& best = envelope[upper_bound(breakpoints.begin(), breakpoints.end(), lambda) - breakpoints.begin()];
+		evaluate(best);
+		if(cost < cost_at(h, lambda)){
+			update_storage(h);
+			get<2>(h) = get<2>(best);
 		}
-		c_explo++;
-		h_explo++;
-    }
+	}
 }
 
 // Test if the low_explo partition gives a better cost for the actual lambda
@@ -410,7 +658,7 @@ void Compressor::make_homogeneous(){
 void Compressor::test_weak_low(){
 	wlow = false;
 	lambda = get<0>(optim_trials);
-	get_objective(*get<2>(*low_explo));
+	evaluate(*low_explo);
 	if(cost < get<1>(optim_trials))
 		wlow = true;
 }
@@ -420,7 +668,7 @@ void Compressor::test_weak_low(){
 void Compressor::test_weak_up(){
 	wup = false;
 	lambda = get<0>(optim_trials);
-	get_objective(*get<2>(*up_explo));
+	evaluate(*up_explo);
 	if(cost < get<1>(optim_trials))
 		wup = true;
 }
@@ -430,7 +678,7 @@ void Compressor::test_weak_up(){
 void Compressor::test_strength_low(){
 	slow = false;
 	lambda = get<0>(*low_explo);
-	get_objective(*get<2>(optim_trials));
+	evaluate(optim_trials);
 	if(cost <= get<1>(*low_explo))
 		slow = true;
 }
@@ -440,7 +688,7 @@ void Compressor::test_strength_low(){
 void Compressor::test_strength_up(){
 	sup = false;
 	lambda = get<0>(*up_explo);
-	get_objective(*get<2>(optim_trials));
+	evaluate(optim_trials);
 	if(cost <= get<1>(*up_explo))
 		sup = true;
 }
@@ -492,6 +740,21 @@ void Compressor::print_to_print(){
 	}
 }
 
+// Print the lower envelope and its breakpoints
+void Compressor::print_envelope(){
+	cout << "Lower envelope : " << endl;
+	for(int i = 0; i < envelope.size(); i++){
+		cout << "lambda : " << get<0>(envelope[i]);
+		if(i < breakpoints.size())
+			cout << " to " << breakpoints[i];
+		else
+			cout << " to inf";
+		cout << "  Rsize : " << get<3>(envelope[i])
+			 << "  dkl : " << get<6>(envelope[i])
+			 << "  partition : " << get<2>(envelope[i]) << endl;
+	}
+}
+
 // Print optim_trials
 void Compressor::print_optim_trials(){
 	cout << "optim trials : " << endl;
@@ -509,6 +772,7 @@ bool compare_memory(const storage& lhs, const storage& rhs) {
 void Compressor::write_partitions(vector<storage>& S){
 	make_filenames("");
     write_header();
+    write_envelope();
 	
 	to_print = S;
 	vector<storage>::iterator it = unique(to_print.begin(), to_print.end(), compare_memory);
@@ -518,4 +782,42 @@ void Compressor::write_partitions(vector<storage>& S){
     	make_filenames("_lambda=" + to_string(get<0>(p)) + "_");
    		write_partition(p);
     }
-}
\ No newline at end of file
+}
+// Add the lower envelope to the meta file, one line per partition with
+// the range of lambda where it is the best
+void Compressor::write_envelope(){
+	if(envelope.empty())
+		return;
+	ofstream metafile;
+	metafile.open(meta_filename, ios::app);
+	if(metafile.is_open()){
+		metafile << endl << "Lower envelope : " << endl;
+		metafile << "lambda_start,lambda_end,Rsize,dkl" << endl;
+		for(int i = 0; i < envelope.size(); i++){
+			metafile << get<0>(envelope[i]) << ",";
+			if(i < breakpoints.size())
+				metafile << breakpoints[i];
+			else
+				metafile << "inf";
+			metafile << "," << get<3>(envelope[i]) << "," << get<6>(envelope[i]) << endl;
+		}
+		metafile.close();
+	}
+	else
+		cout << "Error opening meta file for writing" << endl;
+}
+
+// Add the Pareto archive to the meta file, one line per partition
+void Compressor::write_archive(){
+	ofstream metafile;
+	metafile.open(meta_filename, ios::app);
+	if(metafile.is_open()){
+		metafile << endl << "Pareto archive : " << endl;
+		metafile << "Rsize,dkl" << endl;
+		for(auto& p : pareto)
+			metafile << get<3>(p.second) << "," << get<6>(p.second) << endl;
+		metafile.close();
+	}
+	else
+		cout << "Error opening meta file for writing" << endl;
+}
@@ -31,106 +31,37 @@ Data_Brick::Data_Brick(int d):Brick(d){}
 
 Data_Brick::~Data_Brick(){}
 
-void Data_Brick::get_weight(){
-
-	//cout << spaces[dim] << "get weight in brick : " << this << " belonging to dim " << dim << endl;
-	brick_cursor = nodes.begin();
-	rect_cursor = (*r)[dim]->begin();
-
-	while(rect_cursor != (*r)[dim]->end() and brick_cursor != nodes.end()){
-		if(distance((*r)[dim]->begin(), (*r)[dim]->end()) < distance(nodes.begin(), nodes.end())){
-			//cout << spaces[dim] << "searching rect in brick : node " << *rect_cursor << endl;
-			brick_cursor = lower_bound(brick_cursor, nodes.end()-1, *rect_cursor);
-			//cout << "Search result in brick_cursor on : " << *rect_cursor << endl;
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found,";
-				weight += datas[distance(nodes.begin(), brick_cursor)];
-				//cout << " increasing weight by " << datas[distance(nodes.begin(), brick_cursor)] << endl; 
-			}
-			rect_cursor++;
-		}
-		else{
-			//cout << spaces[dim] << "searching brick in rect : node " << *brick_cursor << endl;
-			rect_cursor = lower_bound(rect_cursor, (*r)[dim]->end()-1, *brick_cursor);
-			//cout << "Search result in rect_cursor on : " << *rect_cursor << endl;
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found";
-				weight += datas[distance(nodes.begin(), brick_cursor)];
-				//cout << " increasing weight by " << datas[distance(nodes.begin(), brick_cursor)] << endl; 
-			}
-			brick_cursor++;
-		}
-	}
+void Data_Brick::query(Query_Context& q) const{
+	const Module_View& module = q.r[dim];
+	Sorted_Set::for_each_match(nodes.data(), nodes.size(), module.data(), module.size(), [&](int i){
+		q.add(datas[i]);
+	});
 }
 
-void Data_Brick::get_info(){
-	brick_cursor = nodes.begin();
-	rect_cursor = (*r)[dim]->begin();
-
-	while(rect_cursor != (*r)[dim]->end() and brick_cursor != nodes.end()){
-		if(distance((*r)[dim]->begin(), (*r)[dim]->end()) < distance(nodes.begin(), nodes.end())){
-			//cout << spaces[dim] << "searching rect in brick : node " << *rect_cursor << endl;
-			brick_cursor = lower_bound(brick_cursor, nodes.end()-1, *rect_cursor);
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found,";
-				info += datas[distance(nodes.begin(), brick_cursor)]*log2(datas[distance(nodes.begin(), brick_cursor)]);
-				//cout << " increasing weight by " << datas[distance(nodes.begin(), brick_cursor)] << endl; 
-			}
-			rect_cursor++;
-		}
-		else{
-			//cout << spaces[dim] << "searching brick in rect : node " << *brick_cursor << endl;
-			rect_cursor = lower_bound(rect_cursor, (*r)[dim]->end()-1, *brick_cursor);
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found";
-				info += datas[distance(nodes.begin(), brick_cursor)]*log2(datas[distance(nodes.begin(), brick_cursor)]);
-				//cout << " increasing weight by " << datas[distance(nodes.begin(), brick_cursor)] << endl; 
-			}
-			brick_cursor++;
-		}
-	}
+void Data_Brick::fragment_query(Fragment_Context& q, int n) const{
+	const Module_View& module = q.r[dim];
+	Sorted_Set::for_each_match(nodes.data(), nodes.size(), module.data(), module.size(), [&](int i){
+		q.weights[q.side(n, dim, nodes[i])] += datas[i];
+	});
 }
 
-void Data_Brick::get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value){
+void Data_Brick::get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value) const{
 	for(int i = 0; i < nodes.size(); i++){
 		nnz_cells.push_back(value+nodes[i]*shifts[dim]);
 	}
 }
 
-void Data_Brick::get_non_zero(Rectangle* R){
-	//cout << spaces[dim] << "get weight in brick : " << this << " belonging to dim " << dim << endl;
-	brick_cursor = nodes.begin();
-	rect_cursor = (*r)[dim]->begin();
-
-	while(rect_cursor != (*r)[dim]->end() and brick_cursor != nodes.end()){
-		if(distance((*r)[dim]->begin(), (*r)[dim]->end()) < distance(nodes.begin(), nodes.end())){
-			//cout << spaces[dim] << "searching rect in brick : node " << *rect_cursor << endl;
-			brick_cursor = lower_bound(brick_cursor, nodes.end()-1, *rect_cursor);
-			//cout << "Search result in brick_cursor on : " << *rect_cursor << endl;
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found,";
-				non_zero++;
-				//cout << " increasing weight by " << datas[distance(nodes.begin(), brick_cursor)] << endl; 
-			}
-			rect_cursor++;
-		}
-		else{
-			//cout << spaces[dim] << "searching brick in rect : node " << *brick_cursor << endl;
-			rect_cursor = lower_bound(rect_cursor, (*r)[dim]->end()-1, *brick_cursor);
-			//cout << "Search result in rect_cursor on : " << *rect_cursor << endl;
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found";
-				non_zero++;
-				//cout << " increasing weight by " << datas[distance(nodes.begin(), brick_cursor)] << endl; 
-			}
-			brick_cursor++;
-		}
+void Data_Brick::get_cells(std::vector<int>& coords, std::vector<double>& values, std::vector<int>& path){
+	for(int i = 0; i < nodes.size(); i++){
+		path[dim] = nodes[i];
+		coords.insert(coords.end(), path.begin(), path.end());
+		values.push_back(datas[i]);
 	}
 }
 
 void Data_Brick::insert_value(int node, double value){
 	//	cout << "inserting value : " << value << endl;
-	brick_cursor = lower_bound(nodes.begin(), nodes.end(), node);
+	auto brick_cursor = lower_bound(nodes.begin(), nodes.end(), node);
 	//If the node doesn't exist : insert it
 	if(brick_cursor == nodes.end()){
 		//cout << "Inserting new value at end of datas" << endl;
@@ -139,7 +70,7 @@ void Data_Brick::insert_value(int node, double value){
 		//brick_cursor = nodes.insert(brick_cursor, node);
 		//datas.insert(datas.begin() + distance(nodes.begin(), brick_cursor), value);
 	}
-	else if(*brick_cursor != value){
+	else if(*brick_cursor != node){
 		//cout << "Inserting new value somewhere in data" << endl;
 		brick_cursor = nodes.insert(brick_cursor, node);
 		datas.insert(datas.begin() + distance(nodes.begin(), brick_cursor), value);
@@ -152,6 +83,11 @@ void Data_Brick::insert_value(int node, double value){
 
 }
 
+void Data_Brick::append_value(int node, double value){
+	nodes.push_back(node);
+	datas.push_back(value);
+}
+
 void Data_Brick::normalize(double Eg){
 	for(int k = 0; k < datas.size(); k++){
 		datas[k] /= Eg; 
@@ -176,9 +112,13 @@ void Data_Brick::print_bricks(){
 	cout << endl;
 }
 
+size_t Data_Brick::memory_footprint(){
+	return sizeof(Data_Brick) + nodes.capacity()*sizeof(int) + datas.capacity()*sizeof(double);
+}
+
 void Data_Brick::print_data_on_file(std::ofstream& datafile, int N){
 	for(int i = 0; i < N; i++){
-		brick_cursor = lower_bound(nodes.begin(), nodes.end(), i);
+		auto brick_cursor = lower_bound(nodes.begin(), nodes.end(), i);
 		if(brick_cursor != nodes.end()){
 			if(*brick_cursor == i){
 				datafile << datas[distance(nodes.begin(), brick_cursor)];
@@ -200,56 +140,35 @@ void Data_Brick::print_data_on_file(std::ofstream& datafile, int N){
 }
 
 
-void Data_Brick::make_micro(std::vector<Rectangle*>& R, rect_structure* rect){
+void Data_Brick::make_micro(std::vector<Rectangle*>& R, rect_structure* rect, Rectangle_Pool& pool){
 	Rectangle* r;
 
 	if(nodes.size() > 1){
 		for(int i = 1; i < nodes.size(); i++){
 			rect_structure* rect_copy = new rect_structure(*rect);
 			//cout << spaces[dim] << "Making the copy " << rect_copy << " of rect " << rect << " on dim " << dim << " adding " << nodes[i] <<endl;
-			rect_copy->push_back(make_shared<vector<int>>());
-			(*rect_copy)[dim]->push_back(nodes[i]);
-			r = new Rectangle(rect_copy);
+			rect_copy->push_back(Module());
+			(*rect_copy)[dim].push_back(nodes[i]);
+			r = pool.make(*rect_copy);
+			delete rect_copy;
 			R.push_back(r);
 		}
 	}
 
-	rect->push_back(make_shared<vector<int>>());
-	(*rect)[dim]->push_back(nodes[0]);
+	rect->push_back(Module());
+	(*rect)[dim].push_back(nodes[0]);
 	//cout << spaces[dim] << "Making the rect " << rect << " on dim " << dim << " adding " << nodes[0] << endl;
-	r = new Rectangle(rect);
+	r = pool.make(*rect);
+	delete rect;
 	R.push_back(r);
 }
 
 
 //void Data_Brick::atomise(Rectangle* ref_rect, std::vector<Rectangle*>& new_Rs){}
 
-void Data_Brick::shrink(rect_structure* rect){
-	brick_cursor = nodes.begin();
-	rect_cursor = (*r)[dim]->begin();
-
-	while(rect_cursor != (*r)[dim]->end() and brick_cursor != nodes.end()){
-		if(distance((*r)[dim]->begin(), (*r)[dim]->end()) < distance(nodes.begin(), nodes.end())){
-			//cout << spaces[dim] << "searching rect in brick : node " << *rect_cursor << endl;
-			brick_cursor = lower_bound(brick_cursor, nodes.end()-1, *rect_cursor);
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found" << endl;
-				(*rect)[dim]->push_back(*brick_cursor);
-			}
-			rect_cursor++;
-		}
-		else{
-			//cout << spaces[dim] << "searching brick in rect : node " << *brick_cursor << endl;
-			rect_cursor = lower_bound(rect_cursor, (*r)[dim]->end()-1, *brick_cursor);
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found" << endl;
-				(*rect)[dim]->push_back(*brick_cursor);
-			}
-			brick_cursor++;
-		}
-	}
+void Data_Brick::shrink(const Rectangle& r, vector<vector<int>>& found) const{
+	Module_View module = r[dim];
+	Sorted_Set::for_each_match(nodes.data(), nodes.size(), module.data(), module.size(), [&](int i){
+		found[dim].push_back(nodes[i]);
+	});
 }
-
-
-
-
@@ -29,10 +29,13 @@
 using namespace std;
 
 
-Data_Tree::Data_Tree(vector<int> N) : N(N), D(N.size()), E(0), Ew(0){	
+Data_Tree::Data_Tree(vector<int> N, string layout) : N(N), D(N.size()), E(0), Ew(0), layout(layout), fiber(nullptr){	
 }
 
-Data_Tree::Data_Tree() : N(vector<int>(0)), D(0), E(0), Ew(0){
+Data_Tree::Data_Tree(string layout) : N(vector<int>(0)), D(0), E(0), Ew(0), layout(layout), fiber(nullptr){
+}
+
+Data_Tree::Data_Tree() : N(vector<int>(0)), D(0), E(0), Ew(0), layout("brick"), fiber(nullptr){
 }
 
 Data_Tree::~Data_Tree(){
@@ -41,6 +44,8 @@ Data_Tree::~Data_Tree(){
 			delete nodes[i];
 	}
 	nodes.clear();
+	if(fiber != nullptr)
+		delete fiber;
 }
 
 //This function takes a hyperlinks and insert it in the data structure
@@ -95,6 +100,146 @@ void Data_Tree::make_bricks(){
 	//cout << endl;
 }
 
+//Insert a batch of cells (D coordinates per cell in coords, any order).
+//The cells are sorted, the duplicates aggregated, and the data tree
+//is built in one pass over them.
+void Data_Tree::insert_cells(vector<int> coords, vector<double> values){
+	//Cells already in the tree are merged with the new ones
+	get_cells(coords, values);
+	for(int i = 0; i < nodes.size(); i++)
+		if(nodes[i]){
+			delete nodes[i];
+			nodes[i] = nullptr;
+		}
+	if(fiber){
+		delete fiber;
+		fiber = nullptr;
+	}
+
+	sort_cells(N, coords, values);
+	if(layout == "fiber"){
+		nodes.clear();
+		fiber = new Fiber_Tree(N);
+		fiber->build(coords, values);
+		return;
+	}
+	nodes.resize(N[0], nullptr);
+	build_bricks(values.size(), [&](size_t e, int d){return coords[e*D + d];}, values.data());
+}
+
+//Insert sorted columns without duplicates (columns[d][e] is the node of cell e on dimension d).
+//The fiber layout keeps pointers on the last column and on the values.
+bool Data_Tree::insert_columns(const vector<const int*>& columns, const double* values, size_t n){
+	if(layout == "fiber"){
+		fiber = new Fiber_Tree(N);
+		if(fiber->build(columns, values, n))
+			return true;
+		delete fiber;
+		fiber = nullptr;
+		return false;
+	}
+	for(size_t e = 0; e < n; e++){
+		int first = 0;
+		if(e > 0){
+			while(first < D and columns[first][e] == columns[first][e-1])
+				first++;
+			if(first == D or columns[first][e] < columns[first][e-1])
+				return false;
+		}
+		for(int d = first; d < D; d++)
+			if(columns[d][e] < 0 or columns[d][e] >= N[d])
+				return false;
+	}
+	nodes.resize(N[0], nullptr);
+	build_bricks(n, [&](size_t e, int d){return columns[d][e];}, values);
+	return true;
+}
+
+//Move the data from the bricks to the flat arrays if the "fiber" layout was chosen.
+//The bricks are visited in lexicographic order, so the cells come sorted.
+void Data_Tree::make_layout(){
+	if(layout != "fiber" or fiber)
+		return;
+	vector<int> coords;
+	vector<double> values;
+	get_cells(coords, values);
+	for(int i = 0; i < nodes.size(); i++)
+		if(nodes[i])
+			delete nodes[i];
+	nodes.clear();
+	nodes.shrink_to_fit();
+
+	fiber = new Fiber_Tree(N);
+	fiber->build(coords, values);
+}
+
+//Sort cells in lexicographic order and aggregate the duplicates.
+//When the nodes of a cell fit in 64 bits, cells are sorted on packed keys.
+void Data_Tree::sort_cells(const vector<int>& N, vector<int>& coords, vector<double>& values){
+	int D = N.size();
+	size_t n = values.size();
+	vector<int> bits(D);
+	int total_bits = 0;
+	for(int d = 0; d < D; d++){
+		bits[d] = (N[d] > 1) ? 64 - __builtin_clzll(N[d]-1) : 0;
+		total_bits += bits[d];
+	}
+
+	if(total_bits <= 64){
+		vector<pair<uint64_t, double>> cells(n);
+		for(size_t e = 0; e < n; e++){
+			uint64_t key = 0;
+			for(int d = 0; d < D; d++)
+				key = (key << bits[d]) | (uint64_t)coords[e*D + d];
+			cells[e] = {key, values[e]};
+		}
+		parallel_sort(cells.begin(), cells.end(),
+			[](const pair<uint64_t, double>& a, const pair<uint64_t, double>& b){return a.first < b.first;});
+
+		size_t m = 0;
+		for(size_t e = 0; e < n; e++){
+			if(m > 0 and cells[m-1].first == cells[e].first)
+				cells[m-1].second += cells[e].second;
+			else
+				cells[m++] = cells[e];
+		}
+		coords.resize(m*D);
+		values.resize(m);
+		for(size_t e = 0; e < m; e++){
+			uint64_t key = cells[e].first;
+			for(int d = D-1; d >= 0; d--){
+				coords[e*D + d] = key & ((uint64_t(1) << bits[d]) - 1);
+				key >>= bits[d];
+			}
+			values[e] = cells[e].second;
+		}
+		return;
+	}
+
+	vector<size_t> order(n);
+	iota(order.begin(), order.end(), 0);
+	parallel_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+		return lexicographical_compare(coords.begin() + a*D, coords.begin() + (a+1)*D,
+			coords.begin() + b*D, coords.begin() + (b+1)*D);
+	});
+
+	vector<int> sorted_coords;
+	vector<double> sorted_values;
+	sorted_coords.reserve(coords.size());
+	sorted_values.reserve(n);
+	for(size_t e : order){
+		auto cell = coords.begin() + e*D;
+		if(!sorted_values.empty() and equal(cell, cell + D, sorted_coords.end() - D))
+			sorted_values.back() += values[e];
+		else{
+			sorted_coords.insert(sorted_coords.end(), cell, cell + D);
+			sorted_values.push_back(values[e]);
+		}
+	}
+	coords.swap(sorted_coords);
+	values.swap(sorted_values);
+}
+
 // void Data_Tree::normalize(){
 // 	for(auto e : nodes){
 // 		if(e != nullptr){
@@ -103,58 +248,68 @@ void Data_Tree::make_bricks(){
 // 	}
 // }
 
-void Data_Tree::get_weight(Rectangle* R){
-	Brick::weight = 0;
-	Brick::r = R->rectangle;
-	
-	for(int v : *((*R->rectangle)[0])){
+//All the state of the traversal lives in the context, so
+//several queries can run on the same data tree at once.
+Query_Result Data_Tree::query(const Module_View* modules, int fields) const{
+	Query_Context q(modules, fields);
+	if(fiber){
+		fiber->query(q);
+		return q.result;
+	}
+	for(int v : modules[0]){
 		if(nodes[v]){
-			nodes[v]->get_weight();
+			nodes[v]->query(q);
 		}
-		//do we have to check for null ptr ?
 	}
-	//cout << "Rectangle " << R << " weight : " << Brick::weight << endl;
+	return q.result;
 }
 
-void Data_Tree::get_info(Rectangle* R){
-	Brick::info = 0;
-	Brick::r = R->rectangle;
-	
-	for(int v : *((*R->rectangle)[0])){
-		//cout << "node : " << v << endl;
-		if(nodes[v]){
-			nodes[v]->get_info();
-		}
+Query_Result Data_Tree::query(const Rectangle* R, int fields) const{
+	Rectangle_Views modules(*R);
+	return query(modules.data(), fields);
+}
+
+double Data_Tree::get_weight(const Rectangle* R) const{
+	return query(R, QUERY_WEIGHT).weight;
+}
+
+//One traversal of R, each cell is summed in the fragment given by
+//the sides of its nodes
+void Data_Tree::fragment_weights(const Rectangle* R, const vector<vector<char>>& inside, vector<double>& weights) const{
+	Rectangle_Views modules(*R);
+	weights.assign(size_t(1) << D, 0);
+	Fragment_Context q(modules.data(), inside.data(), weights.data());
+	if(fiber){
+		fiber->fragment_query(q);
+		return;
 	}
-	//cout << endl << "Rectangle info " << Brick::info << endl;
+	for(int v : q.r[0])
+		if(nodes[v])
+			nodes[v]->fragment_query(q, q.side(0, 0, v));
 }
 
-void Data_Tree::get_nnz(std::vector<int>& nnz_cells){
-	shifts.resize(D, 1);
+double Data_Tree::get_info(const Rectangle* R) const{
+	return query(R, QUERY_INFO).info;
+}
+
+int Data_Tree::get_non_zero(const Rectangle* R) const{
+	return query(R, QUERY_NON_ZERO).non_zero;
+}
+
+void Data_Tree::get_nnz(std::vector<int>& nnz_cells) const{
+	vector<int> shifts(D, 1);
 	for(int d = 1; d < D; d++)
 		shifts[d] =  accumulate(N.begin(), N.begin()+d, 1, multiplies<>());
 	//cout << "shifts datatree : " << endl;
 	print(shifts);
+	if(fiber)
+		fiber->get_nnz(nnz_cells, shifts);
 	for(int i = 0; i < nodes.size(); i++){
 		if(nodes[i]){
 			nodes[i]->get_nnz(nnz_cells, shifts, i*shifts[0]);
 		}
 	}
 	sort(nnz_cells.begin(), nnz_cells.end());
-	//cout << endl << "Rectangle info " << Brick::info << endl;
-}
-
-void Data_Tree::get_non_zero(Rectangle* R){
-	Brick::non_zero = 0;
-	Brick::r = R->rectangle;
-	
-	for(int v : *((*R->rectangle)[0])){
-		//cout << "node : " << v << endl;
-		if(nodes[v]){
-			nodes[v]->get_non_zero(R);
-		}
-	}
-	//cout << endl << "Rectangle info " << Brick::info << endl;
 }
 
 void Data_Tree::make_brick_spaces(){
@@ -168,6 +323,10 @@ void Data_Tree::make_brick_spaces(){
 }
 
 void Data_Tree::print_data(){
+	if(fiber){
+		fiber->print_data();
+		return;
+	}
 	cout << "First level Nodes : " << endl;
 	for(int i = 0; i < N[0]; i++){
 		if(nodes[i])
@@ -193,6 +352,7 @@ void Data_Tree::print_metadata(){
 	cout << "Ew :  " << Ew << endl;
 	cout << "N  :  " << endl;
 	print(N);
+	cout << "Layout : " << layout << ", " << memory_footprint() << " bytes" << endl;
 }
 
 void Data_Tree::print_data_on_file(string filename){
@@ -200,6 +360,8 @@ void Data_Tree::print_data_on_file(string filename){
     datafile.open(filename, ios::out);
     if (datafile.is_open())
     {   
+		if(fiber)
+			fiber->print_data_on_file(datafile);
 		for(auto e : nodes){
 			if(e)
 				e->print_data_on_file(datafile, N[1]);
@@ -218,14 +380,80 @@ void Data_Tree::print_data_on_file(string filename){
         std::cout << "Error opening file for writing datas" << endl;
 }
 
-void Data_Tree::make_micro(std::vector<Rectangle*>& R){
+//Non-zero cells, D ints per cell in coords
+void Data_Tree::get_cells(vector<int>& coords, vector<double>& values){
+	if(fiber){
+		fiber->get_cells(coords, values);
+		return;
+	}
+	vector<int> path(D);
+	for(int i = 0; i < nodes.size(); i++){
+		if(nodes[i]){
+			path[0] = i;
+			nodes[i]->get_cells(coords, values, path);
+		}
+	}
+}
+
+//Write the data in the binary format of Binary_Format.h
+bool Data_Tree::write_binary(string filename){
+	vector<int> coords;
+	vector<double> values;
+	get_cells(coords, values);
+	sort_cells(N, coords, values);
+
+	ofstream binfile(filename, ios::out | ios::binary);
+	if(!binfile.is_open()){
+		cout << "Error opening file for writing binary datas" << endl;
+		return false;
+	}
+	const char pad[8] = {0};
+	Binary_Header header;
+	copy(binary_magic, binary_magic + 8, header.magic);
+	header.D = D;
+	header.reserved = 0;
+	header.E = E;
+	header.ncells = values.size();
+	header.Ew = Ew;
+	binfile.write((const char*)&header, sizeof(header));
+	binfile.write((const char*)N.data(), D*sizeof(int32_t));
+	binfile.write(pad, binary_padded(D*sizeof(int32_t)) - D*sizeof(int32_t));
+
+	vector<int32_t> column(values.size());
+	size_t column_bytes = values.size()*sizeof(int32_t);
+	for(int d = 0; d < D; d++){
+		for(size_t e = 0; e < values.size(); e++)
+			column[e] = coords[e*D + d];
+		binfile.write((const char*)column.data(), column_bytes);
+		binfile.write(pad, binary_padded(column_bytes) - column_bytes);
+	}
+	binfile.write((const char*)values.data(), values.size()*sizeof(double));
+	binfile.close();
+	cout << "Binary datas written in " << filename << endl;
+	return true;
+}
+
+size_t Data_Tree::memory_footprint(){
+	if(fiber)
+		return fiber->memory_footprint();
+	size_t bytes = nodes.capacity()*sizeof(Brick*);
+	for(auto e : nodes)
+		if(e)
+			bytes += e->memory_footprint();
+	return bytes;
+}
+
+void Data_Tree::make_micro(std::vector<Rectangle*>& R, Rectangle_Pool& pool) const{
+	if(fiber){
+		fiber->make_micro(R, pool);
+		return;
+	}
 	for(int i = 0; i < N[0]; i++){
 		if(nodes[i]){
 			rect_structure* rect = new rect_structure();
-			rect->push_back(make_shared<vector<int>>());
-			(*rect)[0]->push_back(i);
+			rect->push_back(Module{i});
 			//cout << "Building rect " << rect << "on dim 0 adding " << i << endl;
-			nodes[i]->make_micro(R, rect);
+			nodes[i]->make_micro(R, rect, pool);
 		}
 	}
 }
@@ -237,7 +465,7 @@ void Data_Tree::atomise(Rectangle* ref_rect, std::vector<Rectangle*>& new_Rs){
 	for(int n : (*((*(ref_rect->rectangle))[0])) ){
 		if(nodes[n]){
 			rect_structure* rect = new rect_structure();
-			rect->push_back(make_shared<vector<int>>());
+			rect->push_back(make_shared<Module>());
 			(*rect)[0]->push_back(n);
 			//cout << "Building rect " << rect << "on dim 0 adding " << i << endl;
 			nodes[n]->atomise(ref_rect, new_Rs, rect);
@@ -246,28 +474,26 @@ void Data_Tree::atomise(Rectangle* ref_rect, std::vector<Rectangle*>& new_Rs){
 }
 */
 
-void Data_Tree::shrink(Rectangle* R){
-	Brick::r = R->rectangle;
-
-	rect_structure* rect = new rect_structure(D);
-	for(int d = 0; d < D; d++)
-    	(*rect)[d] = make_shared<vector<int>>();
-    for(int e : (*(*(R->rectangle))[0])){
-    	if(nodes[e] != nullptr){
-    		(*rect)[0]->push_back(e);
-    		nodes[e]->shrink(rect);
-    	}
-	}
+void Data_Tree::shrink(Rectangle* R) const{
+	vector<vector<int>> found(D);
+	if(fiber)
+		fiber->shrink(*R, found);
+	else
+	    for(int e : (*R)[0]){
+	    	if(nodes[e] != nullptr){
+	    		found[0].push_back(e);
+	    		nodes[e]->shrink(*R, found);
+	    	}
+		}
 
 	//remove duplicates and sort
+	rect_structure rect;
 	for(int d = 0; d < D; d++){
-		sort( (*rect)[d]->begin(), (*rect)[d]->end() );
-		(*rect)[d]->erase(unique(
-			(*rect)[d]->begin(), (*rect)[d]->end()), (*rect)[d]->end());
+		sort(found[d].begin(), found[d].end());
+		found[d].erase(unique(found[d].begin(), found[d].end()), found[d].end());
+		rect.emplace_back(move(found[d]));
 	}
-	//Switch rectangles (delete old)
-	delete R->rectangle;
-	R->rectangle = rect;
+	R->set_modules(rect);
 }
 
 //DEBUG
@@ -313,7 +539,7 @@ std::vector<std::vector <int>>* Data_Tree::make_random_rectangle(){
 
 
 void Data_Tree::printRectangle(const Rectangle& r){
-	for(auto const& m : *(r.rectangle)){
-		print(*m);
+	for(int d = 0; d < r.dimensions(); d++){
+		print(r[d]);
 	}
 }
@@ -0,0 +1,283 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Fiber_Tree.h"
+
+using namespace std;
+
+
+Fiber_Tree::Fiber_Tree(vector<int> N) : D(N.size()), N(N){
+	ptr.resize(D-1);
+	idx.resize(D);
+	ptr[0].assign(N[0]+1, 0);
+	bind();
+}
+
+Fiber_Tree::~Fiber_Tree(){}
+
+//Build the levels in one pass over the sorted cells.
+//Consecutive duplicated cells are aggregated.
+void Fiber_Tree::build(const vector<int>& coords, const vector<double>& values){
+	for(int d = 0; d < D-1; d++)
+		ptr[d].clear();
+	for(int d = 0; d < D; d++)
+		idx[d].clear();
+	vals.clear();
+	ptr[0].assign(N[0]+1, 0);
+
+	const int* prev = nullptr;
+	for(size_t e = 0; e < values.size(); e++){
+		const int* cell = &coords[e*D];
+		//First level on which the cell differs from the previous one
+		int first = 0;
+		if(prev != nullptr)
+			while(first < D and cell[first] == prev[first])
+				first++;
+		if(first == D){
+			vals.back() += values[e];
+			continue;
+		}
+		if(first <= 1)
+			ptr[0][cell[0]+1]++;
+		for(int d = max(first, 1); d < D; d++){
+			if(d < D-1)
+				ptr[d].push_back(idx[d+1].size());
+			idx[d].push_back(cell[d]);
+		}
+		vals.push_back(values[e]);
+		prev = cell;
+	}
+
+	//Close the levels
+	for(int i = 0; i < N[0]; i++)
+		ptr[0][i+1] += ptr[0][i];
+	for(int d = 1; d < D-1; d++)
+		ptr[d].push_back(idx[d+1].size());
+	bind();
+}
+
+//Same pass on columns. Only the upper levels are built, the last
+//level and the values are read in place.
+bool Fiber_Tree::build(const vector<const int*>& columns, const double* values, size_t n){
+	for(int d = 0; d < D-1; d++)
+		ptr[d].clear();
+	for(int d = 0; d < D; d++)
+		idx[d].clear();
+	vals.clear();
+	ptr[0].assign(N[0]+1, 0);
+
+	for(size_t e = 0; e < n; e++){
+		int first = 0;
+		if(e > 0){
+			while(first < D and columns[first][e] == columns[first][e-1])
+				first++;
+			//Cells must be sorted without duplicates
+			if(first == D or columns[first][e] < columns[first][e-1])
+				return false;
+		}
+		for(int d = first; d < D; d++)
+			if(columns[d][e] < 0 or columns[d][e] >= N[d])
+				return false;
+		if(first <= 1)
+			ptr[0][columns[0][e]+1]++;
+		for(int d = max(first, 1); d < D-1; d++){
+			ptr[d].push_back(d+1 < D-1 ? idx[d+1].size() : e);
+			idx[d].push_back(columns[d][e]);
+		}
+	}
+
+	for(int i = 0; i < N[0]; i++)
+		ptr[0][i+1] += ptr[0][i];
+	for(int d = 1; d < D-1; d++)
+		ptr[d].push_back(d+1 < D-1 ? idx[d+1].size() : n);
+	bind();
+	level[D-1] = columns[D-1];
+	cell_vals = values;
+	ncells = n;
+	return true;
+}
+
+void Fiber_Tree::bind(){
+	level.assign(D, nullptr);
+	for(int d = 1; d < D; d++)
+		level[d] = idx[d].data();
+	cell_vals = vals.data();
+	ncells = vals.size();
+}
+
+size_t Fiber_Tree::level_size(int d) const{
+	return (d == D-1) ? ncells : idx[d].size();
+}
+
+void Fiber_Tree::query(Query_Context& q) const{
+	for_each_cell(q.r, [&](int j){
+		q.add(cell_vals[j]);
+	});
+}
+
+void Fiber_Tree::fragment_query(Fragment_Context& q) const{
+	for(int v : q.r[0])
+		if(ptr[0][v] < ptr[0][v+1])
+			fragment_query(1, ptr[0][v], ptr[0][v+1], q, q.side(0, 0, v));
+}
+
+void Fiber_Tree::fragment_query(int d, int begin, int end, Fragment_Context& q, int n) const{
+	if(d == D-1)
+		for_each_common(d, begin, end, q.r[d], [&](int j){
+			q.weights[q.side(n, d, level[d][j])] += cell_vals[j];
+		});
+	else
+		for_each_common(d, begin, end, q.r[d], [&](int j){
+			fragment_query(d+1, ptr[d][j], ptr[d][j+1], q, q.side(n, d, level[d][j]));
+		});
+}
+
+void Fiber_Tree::get_nnz(vector<int>& nnz_cells, vector<int>& shifts) const{
+	for(int v = 0; v < N[0]; v++)
+		for(int j = ptr[0][v]; j < ptr[0][v+1]; j++)
+			get_nnz(1, j, v*shifts[0], nnz_cells, shifts);
+}
+
+void Fiber_Tree::get_nnz(int d, int j, int value, vector<int>& nnz_cells, vector<int>& shifts) const{
+	value += level[d][j]*shifts[d];
+	if(d == D-1)
+		nnz_cells.push_back(value);
+	else
+		for(int c = ptr[d][j]; c < ptr[d][j+1]; c++)
+			get_nnz(d+1, c, value, nnz_cells, shifts);
+}
+
+//One rectangle per non-zero cell
+void Fiber_Tree::make_micro(vector<Rectangle*>& R, Rectangle_Pool& pool) const{
+	vector<int> path(D);
+	for(int v = 0; v < N[0]; v++){
+		path[0] = v;
+		for(int j = ptr[0][v]; j < ptr[0][v+1]; j++)
+			make_micro(1, j, path, R, pool);
+	}
+}
+
+void Fiber_Tree::make_micro(int d, int j, vector<int>& path, vector<Rectangle*>& R, Rectangle_Pool& pool) const{
+	path[d] = level[d][j];
+	if(d == D-1){
+		R.push_back(pool.make(D, [&](int e){
+			return Module_View(&path[e], &path[e] + 1);
+		}));
+	}
+	else
+		for(int c = ptr[d][j]; c < ptr[d][j+1]; c++)
+			make_micro(d+1, c, path, R, pool);
+}
+
+//Collect the nodes of r met while walking down the fibers
+void Fiber_Tree::shrink(const Rectangle& r, vector<vector<int>>& found) const{
+	for(int v : r[0])
+		if(ptr[0][v] < ptr[0][v+1]){
+			found[0].push_back(v);
+			shrink(1, ptr[0][v], ptr[0][v+1], r, found);
+		}
+}
+
+void Fiber_Tree::shrink(int d, int begin, int end, const Rectangle& r, vector<vector<int>>& found) const{
+	for_each_common(d, begin, end, r[d], [&](int j){
+		found[d].push_back(level[d][j]);
+		if(d < D-1)
+			shrink(d+1, ptr[d][j], ptr[d][j+1], r, found);
+	});
+}
+
+//Cells in lexicographic order (D ints per cell in coords)
+void Fiber_Tree::get_cells(vector<int>& coords, vector<double>& values) const{
+	vector<int> path(D);
+	for(int v = 0; v < N[0]; v++){
+		path[0] = v;
+		for(int j = ptr[0][v]; j < ptr[0][v+1]; j++)
+			get_cells(1, j, path, coords, values);
+	}
+}
+
+void Fiber_Tree::get_cells(int d, int j, vector<int>& path, vector<int>& coords, vector<double>& values) const{
+	path[d] = level[d][j];
+	if(d == D-1){
+		coords.insert(coords.end(), path.begin(), path.end());
+		values.push_back(cell_vals[j]);
+	}
+	else
+		for(int c = ptr[d][j]; c < ptr[d][j+1]; c++)
+			get_cells(d+1, c, path, coords, values);
+}
+
+void Fiber_Tree::print_data(){
+	cout << "Fiber tree of " << ncells << " cells" << endl;
+	cout << "level 0 pointers : ";
+	for(int p : ptr[0])
+		cout << p << " ";
+	cout << endl;
+	for(int d = 1; d < D; d++){
+		cout << "level " << d << " nodes : ";
+		for(size_t j = 0; j < level_size(d); j++)
+			cout << level[d][j] << " ";
+		cout << endl;
+		if(d < D-1){
+			cout << "level " << d << " pointers : ";
+			for(int p : ptr[d])
+				cout << p << " ";
+			cout << endl;
+		}
+	}
+	cout << "values : ";
+	for(size_t j = 0; j < ncells; j++)
+		cout << setprecision(10) << cell_vals[j] << " ";
+	cout << endl;
+}
+
+//Same output as the brick tree: a dense matrix when D == 2
+void Fiber_Tree::print_data_on_file(ofstream& datafile){
+	for(int v = 0; v < N[0]; v++){
+		if(ptr[0][v] == ptr[0][v+1] or D == 2){
+			int j = ptr[0][v];
+			for(int i = 0; i < N[1]; i++){
+				if(j < ptr[0][v+1] and level[1][j] == i)
+					datafile << cell_vals[j++];
+				else
+					datafile << 0;
+				if(i < N[1]-1)
+					datafile << " ";
+			}
+			datafile << endl;
+		}
+	}
+}
+
+//Owned arrays only, external columns are not counted
+size_t Fiber_Tree::memory_footprint(){
+	size_t bytes = vals.capacity()*sizeof(double);
+	for(auto& p : ptr)
+		bytes += p.capacity()*sizeof(int);
+	for(auto& i : idx)
+		bytes += i.capacity()*sizeof(int);
+	return bytes;
+}
@@ -28,15 +28,17 @@
 
 using namespace std;
 
-Generater::Generater(vector<int> N, vector<double> params): Data_Tree(N), params(params)
+Generater::Generater(vector<int> N, vector<double> params, string layout): Data_Tree(N, layout), params(params)
 {
 	//cout << "Generater constructor" << endl;
 	setup_constants();
 	build_social_model();
+	insert_cells(move(cells), move(cell_values));
 	make_brick_spaces();
+	make_layout();
 }
 
-Generater::Generater(string type, int n){
+Generater::Generater(string type, int n, string layout): Data_Tree(layout){
 	if(type == "sparse")
 		build_multiscale_sparse_matrix(n);
 	else if(type == "full")
@@ -45,7 +47,9 @@ Generater::Generater(string type, int n){
 		build_small_tester();
 	else
 		cout << "Unknown matrix type" << endl;
+	insert_cells(move(cells), move(cell_values));
 	make_brick_spaces();
+	make_layout();
 }
 
 Generater::Generater(){
@@ -55,6 +59,13 @@ Generater::Generater(){
 Generater::~Generater(){	
 }
 
+//Cells are gathered and the data tree is built once all are known
+void Generater::add_cell(int i, int j, double value){
+	cells.push_back(i);
+	cells.push_back(j);
+	cell_values.push_back(value);
+}
+
 void Generater::setup_constants(){
 	w		= params[0];
 	alpha1 	= params[1];
@@ -67,8 +78,6 @@ void Generater::setup_constants(){
 }
 
 void Generater::build_social_model(){
-	nodes.resize(N[0], nullptr);
-
 	//Random Uniform generator
 	random_device rd_dev;
 	default_random_engine generator(rd_dev());
@@ -123,20 +132,15 @@ void Generater::build_social_model(){
 			}
 		}
 		for(int i : I){
-			if(nodes[i] == nullptr){
-				//cout << "Creating new Data Brick " << i << endl;
-				nodes[i] = new Data_Brick(1);
-			}
 			for(int j : J){
 				//cout << "Working on existing Data Brick " << i << " with neightbour " << j << endl;
 				value = poisson_gen_inRect();
 				E++;
 				Ew += value;
-				nodes[i]->insert_value(j, value);
+				add_cell(i, j, value);
 			}
 		}
 	}
-	//cout << "nodes size  " << nodes.size() << endl;
 	// if(Ew != 1.0)
    	//  	normalize();
 }
@@ -145,7 +149,6 @@ void Generater::build_multiscale_complete_matrix(int n){
 	D = 2;
 	N.push_back(8*n);
 	N.push_back(8*n);
-	nodes.resize(N[0], nullptr);
 
 	vector<double> increment = {0, 0.1, 0.3, 0.6};
 	//Building rectangle 1
@@ -153,14 +156,12 @@ void Generater::build_multiscale_complete_matrix(int n){
 	for(int i = 0; i < 4*n; i++){
 		int x = 0;
 		int k;
-		if(nodes[i] == nullptr)
-			nodes[i] = new Data_Brick(1);
 		for(int j = 0; j < 4; j++){
 			for(k = x; k < x+shift_xaxis1[j]*n; ++k){
 				value = 1+increment[j];
 				E++;
 				Ew += value;
-				nodes[i]->insert_value(k, value);
+				add_cell(i, k, value);
 			}
 			x += shift_xaxis1[j]*n;
 		}
@@ -171,13 +172,11 @@ void Generater::build_multiscale_complete_matrix(int n){
 	int j;
 	for(int i = 0; i < 4; i++){
 		for(j = y; j < y+shift_yaxis2[i]*n; ++j){
-			if(nodes[j] == nullptr)
-				nodes[j] = new Data_Brick(1);
 			for(int k = 6*n; k < 8*n; k++){
 				value = 2+increment[i];
 				E++;
 				Ew += value;
-				nodes[j]->insert_value(k, value);
+				add_cell(j, k, value);
 			}
 		}
 		y += shift_yaxis2[i]*n;
@@ -189,14 +188,12 @@ void Generater::build_multiscale_complete_matrix(int n){
 	for(int i = 6*n; i < 8*n; i++){
 		int x = 4*n;
 		int k;
-		if(nodes[i] == nullptr)
-			nodes[i] = new Data_Brick(1);
 		for(int j = 0; j < 4; j++){
 			for(k = x; k < x+shift_xaxis3[j]*n; ++k){
 				value = 3+increment[j];
 				E++;
 				Ew += value;
-				nodes[i]->insert_value(k, value);
+				add_cell(i, k, value);
 			}
 			x += shift_xaxis3[j]*n;
 		}
@@ -208,14 +205,12 @@ void Generater::build_multiscale_complete_matrix(int n){
 	for(int i = 4*n; i < 6*n; i++){
 		int x = 0;
 		int k;
-		if(nodes[i] == nullptr)
-			nodes[i] = new Data_Brick(1);
 		for(int j = 0; j < 4; j++){
 			for(k = x; k < x+shift_xaxis01[j]*n; ++k){
 				value = 0.01+increment[j];
 				E++;
 				Ew += value;
-				nodes[i]->insert_value(k, value);
+				add_cell(i, k, value);
 			}
 			x += shift_xaxis01[j]*n;
 		}
@@ -226,14 +221,12 @@ void Generater::build_multiscale_complete_matrix(int n){
 	for(int i = 6*n; i < 8*n; i++){
 		int x = 0;
 		int k;
-		if(nodes[i] == nullptr)
-			nodes[i] = new Data_Brick(1);
 		for(int j = 0; j < 3; j++){
 			for(k = x; k < x+shift_xaxis02[j]*n; ++k){
 				value = 0.01+increment[j];
 				E++;
 				Ew += value;
-				nodes[i]->insert_value(k, value);
+				add_cell(i, k, value);
 			}
 			x += shift_xaxis02[j]*n;
 		}
@@ -246,7 +239,6 @@ void Generater::build_multiscale_sparse_matrix(int n){
 	D = 2;
 	N.push_back(8*n);
 	N.push_back(8*n);
-	nodes.resize(N[0], nullptr);
 
 	vector<double> increment = {0, 0.1, 0.3, 0.6};
 	//Building rectangle 1
@@ -254,14 +246,12 @@ void Generater::build_multiscale_sparse_matrix(int n){
 	for(int i = 0; i < 2*n; i++){
 		int x = 0;
 		int k;
-		if(nodes[i] == nullptr)
-			nodes[i] = new Data_Brick(1);
 		for(int j = 0; j < 4; j++){
 			for(k = x; k < x+shift_xaxis1[j]*n; ++k){
 				value = 1+increment[j];
 				E++;
 				Ew += value;
-				nodes[i]->insert_value(k, value);
+				add_cell(i, k, value);
 			}
 			x += shift_xaxis1[j]*n;
 		}
@@ -272,13 +262,11 @@ void Generater::build_multiscale_sparse_matrix(int n){
 	int j;
 	for(int i = 0; i < 4; i++){
 		for(j = y; j < y+shift_yaxis2[i]*n; ++j){
-			if(nodes[j] == nullptr)
-				nodes[j] = new Data_Brick(1);
 			for(int k = 6*n; k < 8*n; k++){
 				value = 2+increment[i];
 				E++;
 				Ew += value;
-				nodes[j]->insert_value(k, value);
+				add_cell(j, k, value);
 			}
 		}
 		y += shift_yaxis2[i]*n;
@@ -286,25 +274,21 @@ void Generater::build_multiscale_sparse_matrix(int n){
 
 	//Building rectangle 3
 	for(int i = 4*n; i < 5*n; i++){
-		if(nodes[i] == nullptr)
-			nodes[i] = new Data_Brick(1);
 		for(int j = 0; j < 3*n; j++){
 			value = 3;
 			E++;
 			Ew += value;
-			nodes[i]->insert_value(j, value);
+			add_cell(i, j, value);
 		}
 	}
 
 	//Building rectangle 4
 	for(int i = 6*n; i < 6*n+n; i++){
-		if(nodes[i] == nullptr)
-			nodes[i] = new Data_Brick(1);
 		for(int j = 2*n; j < 5*n; j++){
 			value = 4;
 			E++;
 			Ew += value;
-			nodes[i]->insert_value(j, value);
+			add_cell(i, j, value);
 		}
 	}
 	
@@ -319,17 +303,14 @@ void Generater::build_small_tester(){
 	D = 2;
 	N.push_back(4);
 	N.push_back(4);
-	nodes.resize(N[0], nullptr);
 
 	vector<double> increment = {0, 0.1, 0.3, 0.6};
 	for(int i = 0; i < N[0]; i++){
-		if(nodes[i] == nullptr)
-			nodes[i] = new Data_Brick(1);
 		value = 1+increment[i];
 		for(int j = 0; j < N[1]; j++){
 			E++;
 			Ew += value;
-			nodes[i]->insert_value(j, value);
+			add_cell(i, j, value);
 		}
 	}
 	// if(Ew != 1.0)
@@ -0,0 +1,259 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <iterator>
+
+#include "Id_Set.h"
+
+using namespace std;
+
+
+vector<Id_Set::Chunk>::iterator Id_Set::find_chunk(int key){
+	return lower_bound(chunks.begin(), chunks.end(), key, [](const Chunk& c, int k){return c.key < k;});
+}
+
+vector<Id_Set::Chunk>::const_iterator Id_Set::find_chunk(int key) const{
+	return lower_bound(chunks.begin(), chunks.end(), key, [](const Chunk& c, int k){return c.key < k;});
+}
+
+void Id_Set::to_bits(Chunk& c){
+	c.bits.assign(chunk_words, 0);
+	for(uint16_t low : c.array)
+		c.bits[low >> 6] |= uint64_t(1) << (low & 63);
+	vector<uint16_t>().swap(c.array);
+}
+
+void Id_Set::to_array(Chunk& c){
+	c.array.clear();
+	c.array.reserve(c.count);
+	for(int w = 0; w < chunk_words; w++)
+		for(uint64_t word = c.bits[w]; word; word &= word - 1)
+			c.array.push_back((w << 6) | __builtin_ctzll(word));
+	vector<uint64_t>().swap(c.bits);
+}
+
+//Ids are mostly inserted in increasing order, the last chunk is tried first
+bool Id_Set::insert(int id){
+	int key = id >> chunk_bits;
+	uint16_t low = id & 0xFFFF;
+	auto c = (!chunks.empty() and chunks.back().key == key) ? chunks.end() - 1 : find_chunk(key);
+	if(c == chunks.end() or c->key != key)
+		c = chunks.insert(c, Chunk{key, 0, {}, {}});
+	if(c->bits.empty()){
+		if(c->array.empty() or c->array.back() < low)
+			c->array.push_back(low);
+		else{
+			auto it = lower_bound(c->array.begin(), c->array.end(), low);
+			if(*it == low)
+				return false;
+			c->array.insert(it, low);
+		}
+		if(++c->count > array_max)
+			to_bits(*c);
+	}
+	else{
+		uint64_t& word = c->bits[low >> 6];
+		uint64_t bit = uint64_t(1) << (low & 63);
+		if(word & bit)
+			return false;
+		word |= bit;
+		c->count++;
+	}
+	count++;
+	return true;
+}
+
+bool Id_Set::erase(int id){
+	int key = id >> chunk_bits;
+	uint16_t low = id & 0xFFFF;
+	auto c = find_chunk(key);
+	if(c == chunks.end() or c->key != key)
+		return false;
+	if(c->bits.empty()){
+		auto it = lower_bound(c->array.begin(), c->array.end(), low);
+		if(it == c->array.end() or *it != low)
+			return false;
+		c->array.erase(it);
+		c->count--;
+	}
+	else{
+		uint64_t& word = c->bits[low >> 6];
+		uint64_t bit = uint64_t(1) << (low & 63);
+		if(!(word & bit))
+			return false;
+		word &= ~bit;
+		if(--c->count <= array_max)
+			to_array(*c);
+	}
+	if(c->count == 0)
+		chunks.erase(c);
+	count--;
+	return true;
+}
+
+void Id_Set::patch(const vector<int>& del, const vector<int>& add){
+	vector<uint16_t> del_low, add_low, kept;
+	size_t i = 0, j = 0;
+	while(i < del.size() or j < add.size()){
+		int key = (j == add.size() or (i < del.size() and del[i] < add[j])) ? del[i] >> chunk_bits : add[j] >> chunk_bits;
+		del_low.clear();
+		add_low.clear();
+		for(; i < del.size() and (del[i] >> chunk_bits) == key; i++)
+			del_low.push_back(del[i] & 0xFFFF);
+		for(; j < add.size() and (add[j] >> chunk_bits) == key; j++)
+			add_low.push_back(add[j] & 0xFFFF);
+
+		auto c = find_chunk(key);
+		if(c == chunks.end() or c->key != key){
+			if(add_low.empty())
+				continue;
+			c = chunks.insert(c, Chunk{key, 0, {}, {}});
+		}
+		count -= c->count;
+		if(c->bits.empty()){
+			kept.clear();
+			set_difference(c->array.begin(), c->array.end(), del_low.begin(), del_low.end(), back_inserter(kept));
+			c->array.clear();
+			set_union(kept.begin(), kept.end(), add_low.begin(), add_low.end(), back_inserter(c->array));
+			c->count = c->array.size();
+			if(c->count > array_max)
+				to_bits(*c);
+		}
+		else{
+			for(uint16_t low : del_low){
+				uint64_t bit = uint64_t(1) << (low & 63);
+				c->count -= (c->bits[low >> 6] & bit) != 0;
+				c->bits[low >> 6] &= ~bit;
+			}
+			for(uint16_t low : add_low){
+				uint64_t bit = uint64_t(1) << (low & 63);
+				c->count += (c->bits[low >> 6] & bit) == 0;
+				c->bits[low >> 6] |= bit;
+			}
+			if(c->count <= array_max)
+				to_array(*c);
+		}
+		count += c->count;
+		if(c->count == 0)
+			chunks.erase(c);
+	}
+}
+
+bool Id_Set::contains(int id) const{
+	int key = id >> chunk_bits;
+	uint16_t low = id & 0xFFFF;
+	auto c = find_chunk(key);
+	if(c == chunks.end() or c->key != key)
+		return false;
+	if(c->bits.empty())
+		return binary_search(c->array.begin(), c->array.end(), low);
+	return (c->bits[low >> 6] >> (low & 63)) & 1;
+}
+
+int Id_Set::select(size_t i) const{
+	for(const Chunk& c : chunks){
+		if(i >= size_t(c.count)){
+			i -= c.count;
+			continue;
+		}
+		int base = c.key << chunk_bits;
+		if(c.bits.empty())
+			return base | c.array[i];
+		for(int w = 0; w < chunk_words; w++){
+			size_t n = __builtin_popcountll(c.bits[w]);
+			if(i < n){
+				uint64_t word = c.bits[w];
+				for(; i > 0; i--)
+					word &= word - 1;
+				return base | (w << 6) | __builtin_ctzll(word);
+			}
+			i -= n;
+		}
+	}
+	return -1;
+}
+
+void Id_Set::or_into(uint64_t* words, size_t n_words) const{
+	for(const Chunk& c : chunks){
+		size_t first = size_t(c.key)*chunk_words;
+		if(c.bits.empty())
+			for(uint16_t low : c.array)
+				words[first + (low >> 6)] |= uint64_t(1) << (low & 63);
+		else{
+			size_t n = min(size_t(chunk_words), n_words - first);
+			uint64_t* out = words + first;
+			const uint64_t* in = c.bits.data();
+			for(size_t w = 0; w < n; w++)
+				out[w] |= in[w];
+		}
+	}
+}
+
+vector<int> Id_Set::ids() const{
+	vector<int> result;
+	result.reserve(count);
+	for_each([&](int id){result.push_back(id);});
+	return result;
+}
+
+bool Id_Set::operator==(const Id_Set& s) const{
+	return count == s.count and ids() == s.ids();
+}
+
+bool Id_Set::is_valid() const{
+	size_t total = 0;
+	for(size_t i = 0; i < chunks.size(); i++){
+		const Chunk& c = chunks[i];
+		if(i > 0 and chunks[i-1].key >= c.key)
+			return false;
+		if(c.count <= 0)
+			return false;
+		if(c.bits.empty()){
+			if(c.count > array_max or c.array.size() != size_t(c.count))
+				return false;
+			for(size_t j = 1; j < c.array.size(); j++)
+				if(c.array[j-1] >= c.array[j])
+					return false;
+		}
+		else{
+			int n = 0;
+			for(uint64_t word : c.bits)
+				n += __builtin_popcountll(word);
+			if(c.count <= array_max or n != c.count or c.bits.size() != size_t(chunk_words))
+				return false;
+		}
+		total += c.count;
+	}
+	return total == count;
+}
+
+size_t Id_Set::memory_footprint() const{
+	size_t bytes = sizeof(Id_Set) + chunks.capacity()*sizeof(Chunk);
+	for(const Chunk& c : chunks)
+		bytes += c.array.capacity()*sizeof(uint16_t) + c.bits.capacity()*sizeof(uint64_t);
+	return bytes;
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ * 
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ * 
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ * 
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Module.h"
+#include "Sorted_Set.h"
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+
+bool Module_View::operator==(const Module_View& m) const{
+	return size() == m.size() and equal(begin(), end(), m.begin());
+}
+
+//Bitset of the nodes, one bit per node
+const vector<uint64_t>& Module::bitset() const{
+	if(!words_valid){
+		words.assign(ids.empty() ? 0 : ids.back()/64 + 1, 0);
+		for(int node : ids)
+			words[node >> 6] |= uint64_t(1) << (node & 63);
+		words_valid = true;
+	}
+	return words;
+}
+
+//Only called when has_bitset()
+inline bool Module::contains(int node) const{
+	size_t w = node >> 6;
+	return w < words.size() and (words[w] >> (node & 63)) & 1;
+}
+
+void Module::intersection(Module_View a, const Module& b, Module& out){
+	out.ids.resize(min(a.size(), b.size()) + Sorted_Set::padding);
+	out.ids.resize(Sorted_Set::intersection(a.data(), a.size(), b.data(), b.size(), out.ids.data()));
+	out.words_valid = false;
+}
+
+void Module::difference(Module_View a, const Module& b, Module& out){
+	out.ids.resize(a.size() + Sorted_Set::padding);
+	out.ids.resize(Sorted_Set::difference(a.data(), a.size(), b.data(), b.size(), out.ids.data()));
+	out.words_valid = false;
+}
+
+void Module::unite(Module_View a, Module_View b, Module& out){
+	out.ids.clear();
+	set_union(a.begin(), a.end(), b.begin(), b.end(), back_inserter(out.ids));
+	out.words_valid = false;
+}
+
+//With a bitset on b, each node of a is sent to one side by testing its bit.
+//Otherwise the sorted arrays are merged. The outputs keep their capacity
+//from one call to the next.
+void Module::split(Module_View a, const Module& b, Module& inter, Module& diff){
+	inter.ids.resize(min(a.size(), b.size()) + Sorted_Set::padding);
+	diff.ids.resize(a.size() + Sorted_Set::padding);
+	size_t ninter = 0, ndiff = 0;
+	if(b.has_bitset() and a.size() + b.size() >= max_bitset_nodes/64){
+		b.bitset();
+		int* in = inter.ids.data();
+		int* out = diff.ids.data();
+		for(int node : a){
+			bool common = b.contains(node);
+			in[ninter] = node;
+			out[ndiff] = node;
+			ninter += common;
+			ndiff += !common;
+		}
+	}
+	else
+		Sorted_Set::split(a.data(), a.size(), b.data(), b.size(), inter.ids.data(), ninter, diff.ids.data(), ndiff);
+	inter.ids.resize(ninter);
+	diff.ids.resize(ndiff);
+	inter.words_valid = diff.words_valid = false;
+}
@@ -36,100 +36,36 @@ Node_Brick::~Node_Brick(){
 		delete bricks[i];
 }
 
-void Node_Brick::get_weight(){
-
-	//cout << spaces[dim] << "get weight in brick : " << this << " belonging to dim " << dim << endl;
-	brick_cursor = nodes.begin();
-	rect_cursor = (*r)[dim]->begin();
-
-	while(rect_cursor != (*r)[dim]->end() and brick_cursor != nodes.end()){
-		if(distance((*r)[dim]->begin(), (*r)[dim]->end()) < distance(nodes.begin(), nodes.end())){
-			//cout << spaces[dim] << "searching rect in brick : node " << *rect_cursor << endl;
-			brick_cursor = lower_bound(brick_cursor, nodes.end()-1, *rect_cursor);
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found" << endl;
-				bricks[distance(nodes.begin(), brick_cursor)]->get_weight();
-			}
-			rect_cursor++;
-		}
-		else{
-			//cout << spaces[dim] << "searching brick in rect : node " << *brick_cursor << endl;
-			rect_cursor = lower_bound(rect_cursor, (*r)[dim]->end()-1, *brick_cursor);
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found" << endl;
-				bricks[distance(nodes.begin(), brick_cursor)]->get_weight();
-			}
-			brick_cursor++;
-		}
-	}
+void Node_Brick::query(Query_Context& q) const{
+	const Module_View& module = q.r[dim];
+	Sorted_Set::for_each_match(nodes.data(), nodes.size(), module.data(), module.size(), [&](int i){
+		bricks[i]->query(q);
+	});
 }
 
-void Node_Brick::get_info(){
-	brick_cursor = nodes.begin();
-	rect_cursor = (*r)[dim]->begin();
-
-	while(rect_cursor != (*r)[dim]->end() and brick_cursor != nodes.end()){
-		if(distance((*r)[dim]->begin(), (*r)[dim]->end()) < distance(nodes.begin(), nodes.end())){
-			//cout << spaces[dim] << "searching rect in brick : node " << *rect_cursor << endl;
-			brick_cursor = lower_bound(brick_cursor, nodes.end()-1, *rect_cursor);
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found" << endl;
-				bricks[distance(nodes.begin(), brick_cursor)]->get_info();
-			}
-			rect_cursor++;
-		}
-		else{
-			//cout << spaces[dim] << "searching brick in rect : node " << *brick_cursor << endl;
-			rect_cursor = lower_bound(rect_cursor, (*r)[dim]->end()-1, *brick_cursor);
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found" << endl;
-				bricks[distance(nodes.begin(), brick_cursor)]->get_info();
-			}
-			brick_cursor++;
-		}
-	}
+void Node_Brick::fragment_query(Fragment_Context& q, int n) const{
+	const Module_View& module = q.r[dim];
+	Sorted_Set::for_each_match(nodes.data(), nodes.size(), module.data(), module.size(), [&](int i){
+		bricks[i]->fragment_query(q, q.side(n, dim, nodes[i]));
+	});
 }
 
-void Node_Brick::get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value){
+void Node_Brick::get_nnz(std::vector<int>& nnz_cells, std::vector<int>& shifts, int value) const{
 	for(int i = 0; i < nodes.size(); i++){
 		bricks[i]->get_nnz(nnz_cells, shifts, value+nodes[i]*shifts[dim]);
 	}
 }
 
-void Node_Brick::get_non_zero(Rectangle* R){
-	//cout << spaces[dim] << "get weight in brick : " << this << " belonging to dim " << dim << endl;
-	brick_cursor = nodes.begin();
-	rect_cursor = (*r)[dim]->begin();
-
-	while(rect_cursor != (*r)[dim]->end() and brick_cursor != nodes.end()){
-		if(distance((*r)[dim]->begin(), (*r)[dim]->end()) < distance(nodes.begin(), nodes.end())){
-			//cout << spaces[dim] << "searching rect in brick : node " << *rect_cursor << endl;
-			brick_cursor = lower_bound(brick_cursor, nodes.end()-1, *rect_cursor);
-			//cout << "Search result in brick_cursor on : " << *rect_cursor << endl;
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found,";
-				non_zero++;
-				//cout << " increasing weight by " << datas[distance(nodes.begin(), brick_cursor)] << endl; 
-			}
-			rect_cursor++;
-		}
-		else{
-			//cout << spaces[dim] << "searching brick in rect : node " << *brick_cursor << endl;
-			rect_cursor = lower_bound(rect_cursor, (*r)[dim]->end()-1, *brick_cursor);
-			//cout << "Search result in rect_cursor on : " << *rect_cursor << endl;
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found";
-				non_zero++;
-				//cout << " increasing weight by " << datas[distance(nodes.begin(), brick_cursor)] << endl; 
-			}
-			brick_cursor++;
-		}
+void Node_Brick::get_cells(std::vector<int>& coords, std::vector<double>& values, std::vector<int>& path){
+	for(int i = 0; i < nodes.size(); i++){
+		path[dim] = nodes[i];
+		bricks[i]->get_cells(coords, values, path);
 	}
 }
 
 Brick* Node_Brick::insert_Node_Brick(int dim, int node){
 	//Si le noeud existe
-	brick_cursor = lower_bound(nodes.begin(), nodes.end(), node);
+	auto brick_cursor = lower_bound(nodes.begin(), nodes.end(), node);
 	if(brick_cursor == nodes.end()){
 		nodes.push_back(node);
 		newbrick = new Node_Brick(dim);
@@ -137,7 +73,7 @@ Brick* Node_Brick::insert_Node_Brick(int dim, int node){
 		return newbrick;
 	}
 	else if(*brick_cursor != node){
-		nodes.insert(brick_cursor, node);
+		brick_cursor = nodes.insert(brick_cursor, node);
 		newbrick = new Node_Brick(dim);
 		bricks.insert(bricks.begin() + distance(nodes.begin(), brick_cursor), newbrick);
 		return newbrick;
@@ -149,7 +85,7 @@ Brick* Node_Brick::insert_Node_Brick(int dim, int node){
 
 Brick* Node_Brick::insert_Data_Brick(int dim, int node){
 	//cout << "	Node Brick " << this << " inserting databrick" << endl;
-	brick_cursor = lower_bound(nodes.begin(), nodes.end(), node);
+	auto brick_cursor = lower_bound(nodes.begin(), nodes.end(), node);
 	if(brick_cursor == nodes.end()){
 		//cout << "	appending at end of nodes" << endl;
 		nodes.push_back(node);
@@ -172,6 +108,18 @@ Brick* Node_Brick::insert_Data_Brick(int dim, int node){
 	}	
 }
 
+Brick* Node_Brick::append_Node_Brick(int dim, int node){
+	nodes.push_back(node);
+	bricks.push_back(new Node_Brick(dim));
+	return bricks.back();
+}
+
+Brick* Node_Brick::append_Data_Brick(int dim, int node){
+	nodes.push_back(node);
+	bricks.push_back(new Data_Brick(dim));
+	return bricks.back();
+}
+
 void Node_Brick::normalize(double Eg){
 	for(auto e : bricks){
 		e->normalize(Eg);
@@ -196,52 +144,36 @@ void Node_Brick::print_bricks(){
 	}
 }
 
+size_t Node_Brick::memory_footprint(){
+	size_t bytes = sizeof(Node_Brick) + nodes.capacity()*sizeof(int) + bricks.capacity()*sizeof(Brick*);
+	for(auto e : bricks)
+		bytes += e->memory_footprint();
+	return bytes;
+}
 
-void Node_Brick::make_micro(std::vector<Rectangle*>& R, rect_structure* rect){	
+void Node_Brick::make_micro(std::vector<Rectangle*>& R, rect_structure* rect, Rectangle_Pool& pool){	
 
 	if(nodes.size() > 1){
 		for(int i = 1; i < nodes.size(); i++){
 			rect_structure* rect_copy = new rect_structure(*rect);
 			//cout << spaces[dim] << "Making the copy " << rect_copy << " of rect " << rect << " on dim " << dim << " adding " << nodes[i] << dim << endl;
-			rect_copy->push_back(make_shared<vector<int>>());
-			(*rect_copy)[dim]->push_back(nodes[i]);
-			bricks[i]->make_micro(R, rect_copy);
+			rect_copy->push_back(Module());
+			(*rect_copy)[dim].push_back(nodes[i]);
+			bricks[i]->make_micro(R, rect_copy, pool);
 		}
 	}
 
-	rect->push_back(make_shared<vector<int>>());
-	(*rect)[dim]->push_back(nodes[0]);
+	rect->push_back(Module());
+	(*rect)[dim].push_back(nodes[0]);
 	//cout << spaces[dim] << "Building rect " << rect << " on dim " << dim << " adding " << nodes[0] << endl;
-	bricks[0]->make_micro(R, rect);
+	bricks[0]->make_micro(R, rect, pool);
 }
 
 //void Node_Brick::atomise(Rectangle* ref_rect, std::vector<Rectangle*>& new_Rs){}
-void Node_Brick::shrink(rect_structure* rect){
-	brick_cursor = nodes.begin();
-	rect_cursor = (*r)[dim]->begin();
-
-	while(rect_cursor != (*r)[dim]->end() and brick_cursor != nodes.end()){
-		if(distance((*r)[dim]->begin(), (*r)[dim]->end()) < distance(nodes.begin(), nodes.end())){
-			//cout << spaces[dim] << "searching rect in brick : node " << *rect_cursor << endl;
-			brick_cursor = lower_bound(brick_cursor, nodes.end()-1, *rect_cursor);
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found" << endl;
-				(*rect)[dim]->push_back(*brick_cursor);
-				bricks[distance(nodes.begin(), brick_cursor)]->shrink(rect);
-			}
-			rect_cursor++;
-		}
-		else{
-			//cout << spaces[dim] << "searching brick in rect : node " << *brick_cursor << endl;
-			rect_cursor = lower_bound(rect_cursor, (*r)[dim]->end()-1, *brick_cursor);
-			if(*brick_cursor == *rect_cursor){
-				//cout << spaces[dim] << "node found" << endl;
-				(*rect)[dim]->push_back(*brick_cursor);
-				bricks[distance(nodes.begin(), brick_cursor)]->shrink(rect);
-			}
-			brick_cursor++;
-		}
-	}
-
+void Node_Brick::shrink(const Rectangle& r, vector<vector<int>>& found) const{
+	Module_View module = r[dim];
+	Sorted_Set::for_each_match(nodes.data(), nodes.size(), module.data(), module.size(), [&](int i){
+		found[dim].push_back(nodes[i]);
+		bricks[i]->shrink(r, found);
+	});
 }
-
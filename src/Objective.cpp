@@ -29,18 +29,23 @@
 using namespace std;
 
 // Constructor for Objective with Data from a Random Matrix Model
-Objective::Objective(vector<int> N, vector<double> params, double lambda) : Operator(N, params), lambda(lambda){}
+Objective::Objective(vector<int> N, vector<double> params, double lambda, string layout) : Operator(N, params, layout), lambda(lambda){}
 
 // Constructor for Objective with Data imported from a file
-Objective::Objective(string input_filename, double lambda) : Operator(input_filename), lambda(lambda){}
+Objective::Objective(string input_filename, double lambda, string layout) : Operator(input_filename, layout), lambda(lambda){}
 
 // Constructor for Objective with Benchmark Data
-Objective::Objective(string type, int n, double lambda) : Operator(type, n), lambda(lambda){}
+Objective::Objective(string type, int n, double lambda, string layout) : Operator(type, n, layout), lambda(lambda){}
+
+// Constructor for Objective over shared data
+Objective::Objective(Data_Tree* shared_data, double lambda) : Operator(shared_data), lambda(lambda){}
 
 // Default Constructor
 Objective::Objective(){}
 
-Objective::~Objective(){}
+Objective::~Objective(){
+    clear_journal();
+}
 
 // To initialize the objective function
 void Objective::initialize_objective(){
@@ -49,10 +54,9 @@ void Objective::initialize_objective(){
 	dkl = 0;
 
 	for(Rectangle* r : R){
-		data_tool->get_weight(r);
-		data_tool->get_info(r);
-		r->weight = Brick::weight;
-		r->info = Brick::info;
+		Query_Result q = data_tool->query(r, QUERY_WEIGHT | QUERY_INFO);
+		r->weight = q.weight;
+		r->info = q.info;
 		r->doLoss();
 		r->doDKL();
 		info += r->info;
@@ -75,8 +79,7 @@ void Objective::get_objective(vector<Rectangle*>& R_){
     dkl = 0;
     Rsize = R_.size();
     for(Rectangle* r : R_){
-        data_tool->get_info(r);
-        r->info = Brick::info;
+        r->info = data_tool->get_info(r);
         r->doLoss();
         r->doDKL();
         info += r->info;
@@ -94,21 +97,18 @@ void Objective::get_objective(vector<Rectangle*>& R_){
 // Calculate a norm
 double Objective::get_dkl_norm(){
     //Make a macro rectangle
-    rect_structure* rect = new rect_structure(D);
-    for(int d = 0; d < D; d++)
-        (*rect)[d] = make_shared<vector<int>>(); //intersection
-
+    rect_structure rect;
     for(int d = 0; d < D; d++){
-        (*rect)[d]->resize(N[d]);
-        iota((*rect)[d]->begin(), (*rect)[d]->end(), 0);
+        vector<int> nodes(N[d]);
+        iota(nodes.begin(), nodes.end(), 0);
+        rect.emplace_back(move(nodes));
     }
     Rectangle* r = new Rectangle(rect);
     
     //Get it's weight and info
-    data_tool->get_weight(r);
-    data_tool->get_info(r);
-    r->weight = Brick::weight;
-    r->info = Brick::info;
+    Query_Result q = data_tool->query(r, QUERY_WEIGHT | QUERY_INFO);
+    r->weight = q.weight;
+    r->info = q.info;
     r->doLoss();
     r->doDKL();
     double retvalue = r->dkl;
@@ -129,24 +129,25 @@ int Objective::check_objective(){
     calculated_loss_check = 0;
 	dkl_check = 0;
 
+	checks.clear();
 	for(Rectangle* r : R){
-		data_tool->get_weight(r);
-		data_tool->get_info(r);
-		r->weight_check = Brick::weight;
-		r->info_check = Brick::info;
-		r->doLossCheck();
-		r->doDKLCheck();
-		weight_check +=  Brick::weight;
-		info_check += Brick::info;
-		loss_check += r->loss_check;
+		Query_Result q = data_tool->query(r, QUERY_WEIGHT | QUERY_INFO);
+		Rectangle_Check& c = checks[r];
+		c.weight = q.weight;
+		c.info = q.info;
+		c.loss = (c.weight > 0) ? -c.weight*log2(c.weight/r->size) : 0;
+		c.dkl = c.info + c.loss;
+		weight_check +=  q.weight;
+		info_check += q.info;
+		loss_check += c.loss;
         calculated_loss_check += r->loss;
-		dkl_check += r->dkl_check;
-		if(abs(r->weight_check - r->weight) > 10e-10){
+		dkl_check += c.dkl;
+		if(abs(c.weight - r->weight) > 10e-10){
 			cout << "weight wrong for rectangle " << r << endl;
-			cout << "calculated : " << r->weight << ", check : " << r->weight_check << endl;
+			cout << "calculated : " << r->weight << ", check : " << c.weight << endl;
 			correct = 1;
 		}
-		if(abs(r->loss_check - r->loss) > 10e-10){
+		if(abs(c.loss - r->loss) > 10e-10){
 			cout << "loss wrong for rectangle " << r << endl;
 			correct = 1;
 		}
@@ -200,181 +201,93 @@ int Objective::check_objective(){
         return 0;
 }
 
-// Build a rectangle with the calculated intersection and difference
-void Objective::calculate_rectangle(){
-    new_r = new rect_structure(D);
-    for(dim = 0; dim < D; dim++){
-        i_d_selector = (int)(n/pow(2, dim))%2;
-        //Check if the pointer should be copied or move
-        if(n != n_move[i_d_selector][dim]){
-            (*new_r)[dim] = inter_diffe[i_d_selector][dim];
-        }
-        else{
-            (*new_r)[dim] = move(inter_diffe[i_d_selector][dim]);
-            inter_diffe[i_d_selector][dim] = make_shared<vector<int>>();
-            n_move[i_d_selector][dim] = -1;
-        }
-    }
-    new_R = new Rectangle(new_r);
-    new_Rs.push_back(new_R);
-}
-
-// Calculate intersection and difference of modules, the size of the resulting rectangles,
-// and when to move the pointer to the calculated components
+// List the fragments of *k, the first one is inside the operating rectangle
 void Objective::calculate_operation(){
-    new_Rs.clear();
-    fill(sizeCheck.begin(), sizeCheck.end(), 1);
-    //Calculate components
-    for(dim = 0; dim < D; dim++){
-        intersection();
-        difference();
-        pow2d = pow(2, dim);
-        for(n = 0; n < n_gen; n++){
-            i_d_selector = (int)(n/pow2d)%2;
-            if(inter_diffe[i_d_selector][dim]->size() > 0){       //Check if the module is empty
-                sizeCheck[n] *= inter_diffe[i_d_selector][dim]->size();
-            }
-            else{
-                sizeCheck[n] = 0;
-                inter_diffe[i_d_selector][dim]->clear();
-            }   
-        }
-    }
-    //Calculate when to move the shared ptr
-    for(n = 0; n < n_gen; n++){
-        if(sizeCheck[n] > 0){
-            for(dim = 0; dim < D; dim++){   
-                i_d_selector = (int)(n/pow(2, dim))%2;        
-                n_move[i_d_selector][dim] = n;
-            }
-        }
-    }
-    //Build the non empty rectangles
-    for(n = 0; n < n_gen; n++){
-        if(sizeCheck[n] > 0){
-            calculate_rectangle();
-        }
-        else{
-            for(dim = 0; dim < D; dim++){
-                i_d_selector = (int)(n/pow(2, dim))%2;
-                if(inter_diffe[i_d_selector][dim]->size() == 0)
-                    n_move[i_d_selector][dim] = -1;
-            }
-        }
-    }
+    (this->*fragment_kernel)(true);
 }
 
 // Calculus of the variation of objective related
-// to the current operation
+// to the current operation. The fragments are scored from the split
+// modules, no rectangle is built until the operation is accepted.
 void Objective::delta_cost(){
 	//Initialize
 	wR = 0;
 	d_dkl = 0;
-    new_Rs_total.clear();
+    scored.clear();
+    flag_rect(1);
 
 	//Operations on Partition
     for(k = to_del.begin(); k != to_del.end(); k++){
-        //Build the new_Rs for this k
+        //List the fragments for this k and weigh them all in one traversal of *k
         calculate_operation();
-        //Calculus of DKL
-        //Find max
-        max_it = max_element(new_Rs.begin(), new_Rs.end(), Compare);
-        //Option 1: the max is inside the operating rectangle -> skip it
-        if(max_it == new_Rs.begin()){
-        	for(n = 1; n < new_Rs.size(); n++){
-    			data_tool->get_weight(new_Rs[n]);
-    			new_Rs[n]->weight = Brick::weight;
-    			new_Rs[n]->doLoss();
-    			d_dkl += new_Rs[n]->loss;
-    			wR -= new_Rs[n]->weight;
-        	}
-        	wR += (*k)->weight;
-        }
-        //option 2: the max is a rectangle that shall be fully calculated
-        else{
-         	Wacc = 0;
-            max_pos = distance(new_Rs.begin(), max_it);
-
-            data_tool->get_weight(new_Rs[0]);
-            new_Rs[0]->weight = Brick::weight;
-            new_Rs[0]->doLoss();
-            Wacc += new_Rs[0]->weight;
-
-        	for(n = 1; n < max_pos; n++){
-    			data_tool->get_weight(new_Rs[n]);
-    			new_Rs[n]->weight = Brick::weight;
-    			new_Rs[n]->doLoss();
-				d_dkl += new_Rs[n]->loss;
-    			Wacc += new_Rs[n]->weight;
-        	}
-        	
-        	for(n = max_pos+1; n < new_Rs.size(); n++){
-    			data_tool->get_weight(new_Rs[n]);
-    			new_Rs[n]->weight = Brick::weight;
-    			new_Rs[n]->doLoss();
-				d_dkl += new_Rs[n]->loss;    			
-    			Wacc += new_Rs[n]->weight;
-        	}
-            
-            wR += new_Rs[0]->weight;
-        	new_Rs[max_pos]->weight = (*k)->weight - Wacc;
-        	new_Rs[max_pos]->doLoss();
-			d_dkl += new_Rs[max_pos]->loss;
-        }
-        delete new_Rs[0];
+        data_tool->fragment_weights(*k, rect_flags, fragment_weights);
+
+        //Calculus of DKL, the fragment inside goes to the operating rectangle
         d_dkl -= (*k)->loss;
-        for(int i = 1; i < new_Rs.size(); i++)
-            if(new_Rs[i]->weight > 10e-10)
-                new_Rs_total.push_back(new_Rs[i]);
-            else{
-                delete new_Rs[i];
+        for(int f : fragment_ids){
+            double weight = fragment_weights[f];
+            if(f == 0){
+                wR += weight;
+                continue;
             }
+            d_dkl += Rectangle::loss_of(weight, fragment_size(f));
+            if(weight > 10e-10)
+                scored.push_back({*k, f, weight});
+        }
     }
+    flag_rect(0);
 
-    if(wR > 10e-10){
-        new_R = new Rectangle(rect);
-        new_R->weight = wR;
-        new_R->doLoss();
-        d_dkl += new_R->loss;
-        new_Rs_total.push_back(new_R);
-    }
-    else{
-        delete rect;
-    }
+    int size = 1;
+    for(int d = 0; d < D; d++)
+        size *= rect[d].size();
+    if(wR > 10e-10)
+        d_dkl += Rectangle::loss_of(wR, size);
 
-    d_Rsize = new_Rs_total.size() - to_del.size();
+    d_Rsize = int(scored.size()) + (wR > 10e-10) - int(to_del.size());
     d_ldkl = dkl_factor*d_dkl;
     d_penalty = penalty_factor*d_Rsize;
     d_cost = d_ldkl + d_penalty;
 }
 
-// Apply an the current operation to thep partition
-void Objective::do_operation(){
-	clean_temp_registers();
-    //*** Update partition
-    sort(new_Rs_total.begin(), new_Rs_total.end());
-
-    buffer.clear();
-    set_difference(R.begin(), R.end(), to_del.begin(), to_del.end(), back_inserter(buffer));
-    buffer.swap(R);
-
-    buffer.clear();
-    set_union(R.begin(), R.end(), new_Rs_total.begin(), new_Rs_total.end(), back_inserter(buffer));
-    buffer.swap(R);
-
-    for(Rectangle* e : to_del){
-        if(e == nullptr)
-            cout << "nullptr in todel" << endl;
-        make_del_reg(e);
-        delete e;
+// Build the rectangles of an accepted operation from the fragments
+// scored by delta_cost
+void Objective::build_operation(){
+    new_Rs_total.clear();
+    auto f = scored.begin();
+    for(k = to_del.begin(); k != to_del.end() and f != scored.end(); k++){
+        if(f->source != *k)
+            continue;
+        for(int d = 0; d < D; d++){
+            dim = d;
+            split();
+        }
+        for(; f != scored.end() and f->source == *k; f++){
+            Rectangle* r = make_fragment(f->n);
+            r->weight = f->weight;
+            r->doLoss();
+            new_Rs_total.push_back(r);
+        }
     }
 
-    for(Rectangle* e : new_Rs_total){
-        make_add_reg(e);
+    if(wR > 10e-10){
+        new_R = pool.make(rect);
+        new_R->weight = wR;
+        new_R->doLoss();
+        new_Rs_total.push_back(new_R);
     }
+}
 
-    //*** Setting up registres III
-    update_registers();
+// Apply an the current operation to thep partition
+void Objective::do_operation(){
+	build_operation();
+    if(journaling){
+        for(Rectangle* r : to_del)
+            journal_removed.push_back(pool.share(r));
+        journal_added.insert(journal_added.end(), new_Rs_total.begin(), new_Rs_total.end());
+        journal.push_back({int(journal_removed.size()), int(journal_added.size()), d_Rsize, d_dkl, d_ldkl, d_penalty, d_cost});
+    }
+    //*** Update partition and registers
+    replace_rectangles(new_Rs_total);
 
     //Update objectif
 	Rsize += d_Rsize;
@@ -386,12 +299,59 @@ void Objective::do_operation(){
 
 }
 
-// Cancel the current operation
+// Cancel the current operation, nothing was built
 void Objective::cancel_operation(){
-	for(Rectangle* e : new_Rs_total){
-        delete e;
+	scored.clear();
+}
+
+// Record the next operations, the state at this point can be restored by rollback
+void Objective::start_journal(){
+    clear_journal();
+    journaling = true;
+}
+
+void Objective::stop_journal(){
+    clear_journal();
+    journaling = false;
+}
+
+// Forget the recorded operations, their removed rectangles are released
+void Objective::clear_journal(){
+    pool.release(journal_removed);
+    journal_added.clear();
+    journal.clear();
+}
+
+// Undo the recorded operations, the last one first. Only the rectangles
+// of these operations move, the registers follow through the batch.
+void Objective::rollback(){
+    while(!journal.empty()){
+        const Journal_Entry& e = journal.back();
+        int removed_begin = journal.size() > 1 ? journal[journal.size()-2].removed_end : 0;
+        int added_begin = journal.size() > 1 ? journal[journal.size()-2].added_end : 0;
+        for(int i = e.added_end - 1; i >= added_begin; i--){
+            Rectangle* r = journal_added[i];
+            edit_registers(r, false);
+            erase_R(r);
+            pool.release(r);
+        }
+        //The reference of the journal goes to the partition
+        for(int i = removed_begin; i < e.removed_end; i++){
+            insert_R(journal_removed[i]);
+            edit_registers(journal_removed[i], true);
+        }
+
+        Rsize -= e.d_Rsize;
+        loss -= e.d_dkl;
+        dkl -= e.d_dkl;
+        ldkl -= e.d_ldkl;
+        penalty -= e.d_penalty;
+        cost -= e.d_cost;
+
+        journal_removed.resize(removed_begin);
+        journal_added.resize(added_begin);
+        journal.pop_back();
     }
-    new_Rs_total.clear();
 }
 
 // Print details related to the objetive
@@ -435,10 +395,11 @@ void Objective::print_cost_rectangles(){
         cout << "loss      : " << e->loss << endl;
         cout << "dkl       : " << e->dkl << endl;
 
-        cout << "weight_check : " << e->weight_check << endl;
-        cout << "info_check   : " << e->info_check << endl;
-        cout << "loss_check   : " << e->loss_check << endl;
-        cout << "dkl_check    : " << e->dkl_check << endl;
+        Rectangle_Check c = checks.count(e) ? checks[e] : Rectangle_Check();
+        cout << "weight_check : " << c.weight << endl;
+        cout << "info_check   : " << c.info << endl;
+        cout << "loss_check   : " << c.loss << endl;
+        cout << "dkl_check    : " << c.dkl << endl;
         cout << endl;
     }
 }
\ No newline at end of file
@@ -30,17 +30,17 @@ using namespace std;
 
 
 // Constructor for Operator with Data from a Random Matrix Model
-Operator::Operator(vector<int> N, vector<double> params) : Checker(N, params){
+Operator::Operator(vector<int> N, vector<double> params, string layout) : Checker(N, params, layout){
     init();
 }
 
 // Constructor for Operator with Data imported from a file
-Operator::Operator(string input_filename) : Checker(input_filename){
+Operator::Operator(string input_filename, string layout) : Checker(input_filename, layout){
     init();
 }
 
 // Constructor for Operator with Benchmark Data
-Operator::Operator(string type, int n): Checker(type, n){
+Operator::Operator(string type, int n, string layout): Checker(type, n, layout){
     init();
 }
 
@@ -49,6 +49,11 @@ Operator::Operator(std::vector<int> N): Checker(N){
     init();
 }
 
+// Constructor for Operator over shared data
+Operator::Operator(Data_Tree* shared_data): Checker(shared_data){
+    init();
+}
+
 //Default Constructor
 Operator::Operator(){
 }
@@ -70,35 +75,37 @@ void Operator::init(){
 
     //This is supposed to be given by user or chosen by the program
     binomial_p = {0.5, 0.5, 0.5, 0.5, 0.5};
+    register_batch_max = 1 << 16;
 
     //Resizing class containers to dimension D
     setup_registers_and_storage();
     //Initializing a very useful number
-    n_gen = pow(2, D);
-    sizeCheck.resize(n_gen);
+    n_gen = 1 << D;
+
+    //The fragments of the usual dimensions are built by unrolled code
+    switch(D){
+        case 2: fragment_kernel = &Operator::fragments<2>; break;
+        case 3: fragment_kernel = &Operator::fragments<3>; break;
+        case 4: fragment_kernel = &Operator::fragments<4>; break;
+        default: fragment_kernel = &Operator::fragments<0>;
+    }
 }
 
 //Initializing the class containers
 void Operator::setup_registers_and_storage(){
-    del_reg.resize(D);
-    add_reg.resize(D);
     regUnionResult.resize(D);
 
-    for(int d = 0; d < D; d++){
-        del_reg[d].resize(N[d]);
-        add_reg[d].resize(N[d]);        
-    }
-
     
-    n_move.resize(2);
-    n_move[0].resize(D);
-    n_move[1].resize(D);
-
-    inter_diffe.resize(2);
-    for(int i = 0; i < D; i++){
-        inter_diffe[0].push_back(make_shared<vector<int>>()); //intersection
-        inter_diffe[1].push_back(make_shared<vector<int>>()); //difference
-    }
+    inter_diffe.assign(2, rect_structure(D)); //intersection and difference
+    rect_flags.resize(D);
+    for(int d = 0; d < D; d++)
+        rect_flags[d].assign(N[d], 0);
+}
+
+//Seed the random number generators, for a reproducible run
+void Operator::seed(unsigned s){
+    generator.seed(s);
+    eng.seed(s);
 }
 
 //To test the random number generator
@@ -112,19 +119,18 @@ void Operator::testRandomNumberGenerator(){
 
 //Builds randomly a new rectangle
 int Operator::find_cluster(){
-    rect = new rect_structure(D);
+    clear_rect();
     for(int d = 0; d < D; d++){
-        (*rect)[d] = make_shared<vector<int>>();
         for(int i = 0; i < N[d]; i++){
             if(uni_r(generator) < binomial_p[d]){
-                (*rect)[d]->push_back(i);
+                rect[d].push_back(i);
             }
         }
-        if((*rect)[d]->size() == 0)
+        if(rect[d].size() == 0)
             return 0;
     }
     to_del.clear();
-    regUnion2();       //Union of register on all dimensions
+    regUnion();        //Union of register on all dimensions
     regIntersection(); //Intersect the unions
     return 1;
 }
@@ -132,40 +138,39 @@ int Operator::find_cluster(){
 //Builds a rectangle by sampling two rectangles from a randomly
 //selected register and calculating the union of them.
 int Operator::find_union_constrained(){
-    rect = new rect_structure(D);
+    clear_rect();
     if(R.size() < 2)
         return 0;
     int d = uni_D(generator);
     int n = uni_reg[d](generator);
 
+    if(dirty_nodes[d][n])
+        patch_registers();
     if(reg[d][n].size() <= 1)
         return 0;
 
     sampled_rects.clear();
     uni_i = uniform_int_distribution<int>(0, reg[d][n].size()-1);
 
-    sampled_rects.push_back(reg[d][n][uni_i(generator)]);
-    sampled_rects.push_back(reg[d][n][uni_i(generator)]);
+    sampled_rects.push_back(slot_map[reg[d][n].select(uni_i(generator))]);
+    sampled_rects.push_back(slot_map[reg[d][n].select(uni_i(generator))]);
 	
     if(sampled_rects[0] == sampled_rects[1])
         return 0;
 
     for(d = 0; d < D; d++){
-        (*rect)[d] = make_shared<vector<int>>();
-        set_union((*((sampled_rects[0])->rectangle))[d]->begin(), (*((sampled_rects[0])->rectangle))[d]->end(),
-                    (*((sampled_rects[1])->rectangle))[d]->begin(), (*((sampled_rects[1])->rectangle))[d]->end(),
-                    back_inserter(*((*rect)[d])));
+        Module::unite((*sampled_rects[0])[d], (*sampled_rects[1])[d], rect[d]);
     }
 
     to_del.clear();
-    regUnion2();        //Union of register on all dimensions
+    regUnion();        //Union of register on all dimensions
     regIntersection(); //Intersect the unions
     return 1;
 }
 
 //Build a rectangle within a randomly selected rectangle
 int Operator::find_division(){
-    rect = new rect_structure(D);
+    clear_rect();
 
     //Pick a rectangle
     uni_i = uniform_int_distribution<int>(0, Rsize-1);
@@ -176,15 +181,14 @@ int Operator::find_division(){
     //Select a subset on each dimension
     check = 0;
     for(int d = 0; d < D; d++){
-        (*rect)[d] = make_shared<vector<int>>();
-        for(auto e : *((*(ref_rect->rectangle))[d])){
+        for(auto e : (*ref_rect)[d]){
             if(uni_r(generator) < 0.5){
-                (*rect)[d]->push_back(e);
+                rect[d].push_back(e);
             }
         }
-        if((*rect)[d]->size() ==  0)
+        if(rect[d].size() ==  0)
             return 0;
-        if((*rect)[d]->size() !=  (*(ref_rect->rectangle))[d]->size())
+        if(rect[d].size() !=  (*ref_rect)[d].size())
             check = 1;
 
     }
@@ -202,7 +206,9 @@ int Operator::find_division(){
 //Extract the components of a Rectangle to prepare an operation
 //Allows to use a rectangle calculated elsewhere in the program as an operating rectangle
 int Operator::applyCluster(Rectangle* clust){
-    rect = new rect_structure(*(clust->rectangle));
+    clear_rect();
+    for(int d = 0; d < D; d++)
+        rect[d].assign((*clust)[d]);
     to_del.clear();
     regUnion();        //Union of register on all dimensions
     regIntersection(); //Intersect the unions
@@ -219,73 +225,57 @@ void Operator::shuffle_partition(int n_ope){
     cout << "Size of R after shuffle : " <<  Rsize << endl;
 }
 
-// Build a rectangle with the calculated intersection and difference
-void Operator::calculate_rectangle(){
-    new_r = new rect_structure(D);
-    for(dim = 0; dim < D; dim++){
-        i_d_selector = (int)(n/pow(2, dim))%2;
-        // Check if the pointer should be copied or move
-        if(n != n_move[i_d_selector][dim]){
-            (*new_r)[dim] = inter_diffe[i_d_selector][dim];
-        }
-        else{
-            (*new_r)[dim] = move(inter_diffe[i_d_selector][dim]);
-            inter_diffe[i_d_selector][dim] = make_shared<vector<int>>();
-            n_move[i_d_selector][dim] = -1;
-        }
-    }                
-    if(n != 0){
-        new_R = new Rectangle(new_r);
-        new_Rs.push_back(new_R);
+// Divide the rectangle being affected (*k) by the operating rectangle. Fragment n takes
+// the intersection on dimension d if bit d of n is 0 and the difference otherwise, so
+// fragment 0 is inside the operating rectangle. The numbers of the non-empty fragments
+// are listed in fragment_ids, fragment 0 only if inside is set. No rectangle is built,
+// the fragments are read from inter_diffe until the next split. DIM is the number of
+// dimensions when it is known at compile time, or 0.
+template <int DIM>
+void Operator::fragments(bool inside){
+    const int dims = DIM > 0 ? DIM : D;
+    const int count = 1 << dims;
+    uint64_t empty = 0; // Bit side*dims+d is set if the component (side, d) is empty
+    for(int d = 0; d < dims; d++){
+        dim = d;
+        split();
+        if(inter_diffe[0][d].empty())
+            empty |= uint64_t(1) << d;
+        if(inter_diffe[1][d].empty())
+            empty |= uint64_t(1) << (dims + d);
     }
-    else
-        delete new_r;
+
+    auto is_empty = [&](int n){
+        for(int d = 0; d < dims; d++)
+            if(empty & (uint64_t(1) << (((n >> d) & 1)*dims + d)))
+                return true;
+        return false;
+    };
+    fragment_ids.clear();
+    for(int n = inside ? 0 : 1; n < count; n++)
+        if(!is_empty(n))
+            fragment_ids.push_back(n);
+}
+
+int Operator::fragment_size(int n) const{
+    int size = 1;
+    for(int d = 0; d < D; d++)
+        size *= inter_diffe[(n >> d) & 1][d].size();
+    return size;
+}
+
+// Each fragment copies its components in its own buffer
+Rectangle* Operator::make_fragment(int n){
+    return pool.make(D, [&](int d) -> const Module& {
+        return inter_diffe[(n >> d) & 1][d];
+    });
 }
 
-// Calculate intersection and difference of modules, the size of the resulting rectangles,
-// and when to move the pointer to the calculated components
+// Calculate the fragments of *k left outside of the operating rectangle
 void Operator::calculate_operation(){
-    // Calculate components and sizes of resulting vectors
-    fill(sizeCheck.begin(), sizeCheck.end(), 1);
-    for(dim = 0; dim < D; dim++){
-        intersection();
-        difference();
-        pow2d = pow(2, dim);
-
-        for(n = 0; n < n_gen; n++){
-            //Remove this if, store (int)(n/pow2d)%2 in a var and use it on inter_diffe
-            i_d_selector = (int)(n/pow2d)%2;
-            if(inter_diffe[i_d_selector][dim]->size() > 0){       //Check if the module is empty
-                sizeCheck[n] *= inter_diffe[i_d_selector][dim]->size();
-            }
-            else{
-                sizeCheck[n] = 0;
-                inter_diffe[i_d_selector][dim]->clear();
-            }   
-        }
-    }
-    //Calculate when to move the shared ptr
-    for(n = 0; n < n_gen; n++){
-        if(sizeCheck[n] > 0){
-            for(dim = 0; dim < D; dim++){   
-                i_d_selector = (int)(n/pow(2, dim))%2;        
-                n_move[i_d_selector][dim] = n;
-            }
-        }
-    }
-    //Build the non-empty rectangles, remember to replace the moved shared ptr
-    for(n = 0; n < n_gen; n++){
-        if(sizeCheck[n] > 0){
-            calculate_rectangle();
-        }
-        else{
-            for(dim = 0; dim < D; dim++){
-                i_d_selector = (int)(n/pow(2, dim))%2;
-                if(inter_diffe[i_d_selector][dim]->size() == 0)
-                    n_move[i_d_selector][dim] = -1;
-            }
-        }
-    }
+    (this->*fragment_kernel)(false);
+    for(int n : fragment_ids)
+        new_Rs.push_back(make_fragment(n));
 }
 
 // Apply a calculated operation
@@ -296,214 +286,100 @@ void Operator::doCluster(){
         calculate_operation();
     }
 
-    new_R = new Rectangle(rect);
+    new_R = pool.make(rect);
     new_Rs.push_back(new_R);
 
-    clean_temp_registers();
-
-    sort(new_Rs.begin(), new_Rs.end());
-    
-    buffer.clear();
-    set_difference(R.begin(), R.end(), to_del.begin(), to_del.end(), back_inserter(buffer));
-    buffer.swap(R);
-
-    buffer.clear();
-    set_union(R.begin(), R.end(), new_Rs.begin(), new_Rs.end(), back_inserter(buffer));
-    buffer.swap(R);
-
-    for(Rectangle* e : to_del){
-        make_del_reg(e);
-        delete e;
-    }
-
-    for(Rectangle* e : new_Rs){
-        make_add_reg(e);
-    }
-
-    //*** Setting up registres
-    update_registers();
+    replace_rectangles(new_Rs);
 
     //*** Update Rsize
     Rsize += new_Rs.size() - to_del.size();
 }
 
-// Cancel an operation
+// Cancel an operation, the operating rectangle keeps its storage
 void Operator::clean_operator(){
-    delete rect;
 }
 
-// Calculated the intersection on each dimension between the modules of the operating
-// rectangle and the modules of the rectangle being affected
-void Operator::intersection(){
-    set_intersection((*((*k)->rectangle))[dim]->begin(), (*((*k)->rectangle))[dim]->end(),
-        (*rect)[dim]->begin(), (*rect)[dim]->end(), back_inserter(*inter_diffe[0][dim]));
+// Set (or clear) the flags of the nodes of the operating rectangle
+void Operator::flag_rect(char value){
+    for(int d = 0; d < D; d++)
+        for(int node : rect[d])
+            rect_flags[d][node] = value;
 }
 
-// Calculated the difference on each dimension between the modules of the operating
-// rectangle and the modules of the rectangle being affected
-void Operator::difference(){
-    set_difference((*((*k)->rectangle))[dim]->begin(), (*((*k)->rectangle))[dim]->end(),
-        (*rect)[dim]->begin(), (*rect)[dim]->end(), back_inserter(*inter_diffe[1][dim]));
+// Empty the modules of the operating rectangle, keeping their capacity
+void Operator::clear_rect(){
+    rect.resize(D);
+    for(Module& m : rect)
+        m.clear();
 }
 
-//Calculate the union of registers
-void Operator::regUnion(){
-    for(int d = 0; d < D; d++){
-        regUnionResult[d].clear();
-        if((*rect)[d]->size() == 1){
-            regUnionResult[d] = reg[d][(*(*rect)[d])[0]];
-        }
-        else{
-            set_union(reg[d][(*((*rect)[d]))[0]].begin(), reg[d][(*((*rect)[d]))[0]].end(),
-                    reg[d][(*((*rect)[d]))[1]].begin(), reg[d][(*((*rect)[d]))[1]].end(),
-                    back_inserter(regUnionResult[d]));
-            if((*rect)[d]->size() > 2){
-                for (size_t i = 2; i < (*rect)[d]->size(); ++i){
-                    buffer.clear();
-
-                    set_union(regUnionResult[d].begin(), regUnionResult[d].end(),
-                    reg[d][(*((*rect)[d]))[i]].begin(), reg[d][(*((*rect)[d]))[i]].end(),
-                    back_inserter(buffer));
-
-                    swap(regUnionResult[d], buffer);
-                }
-            }
-        }
-    }
+// Calculate in one pass the intersection and the difference on dimension dim between
+// the module of the rectangle being affected and the module of the operating rectangle
+void Operator::split(){
+    Module::split((**k)[dim], rect[dim], inter_diffe[0][dim], inter_diffe[1][dim]);
 }
 
-// An alternative to regUnion
-void Operator::regUnion2(){
+//Calculate the union of registers, one bitset of ids per dimension
+void Operator::regUnion(){
+    patch_dirty_registers();
+    size_t words = (slot_map.capacity() + 63)/64;
     for(int d = 0; d < D; d++){
-        regUnionResult[d].clear();
-        if((*rect)[d]->size() == 1){
-            regUnionResult[d] = reg[d][(*(*rect)[d])[0]];
-        }
-        else{
-            set_union(reg[d][(*((*rect)[d]))[0]].begin(), reg[d][(*((*rect)[d]))[0]].end(),
-                    reg[d][(*((*rect)[d]))[1]].begin(), reg[d][(*((*rect)[d]))[1]].end(),
-                    back_inserter(regUnionResult[d]));
-            if((*rect)[d]->size() > 2){
-                pq = priority_queue<vector<Rectangle*>*, vector<vector<Rectangle*>*>, Compare_reg_size>();
-                for(int e : (*(*rect)[d]))
-                    pq.push(&reg[d][e]);
-                regUnionResult[d] = *(pq.top());
-                pq.pop();
-                while(!pq.empty()){
-                    buffer.clear();
-                    set_union(regUnionResult[d].begin(), regUnionResult[d].end(),
-                        pq.top()->begin(), pq.top()->end(),
-                        back_inserter(buffer));
-                        swap(regUnionResult[d], buffer);
-                        pq.pop();
-                }
-            }
-        }
+        regUnionResult[d].assign(words, 0);
+        for(int node : rect[d])
+            reg[d][node].or_into(regUnionResult[d].data(), words);
     }
 }
 
 // Calculate the intersection of the result of regUnion
 void Operator::regIntersection(){
-    set_intersection(regUnionResult[0].begin(), regUnionResult[0].end(),
-        regUnionResult[1].begin(), regUnionResult[1].end(), back_inserter(to_del));
-    if (D == 2) return;
-    for (size_t i = 2; i < D; ++i) {
-        buffer.clear();
-        set_intersection(to_del.begin(), to_del.end(),
-            regUnionResult[i].begin(), regUnionResult[i].end(), back_inserter(buffer));
-        swap(to_del, buffer);
-    }
-}
-
-
-// Make the register of the deleted rectangles
-void Operator::make_del_reg(Rectangle* n){
-    for(int d = 0; d < D; d++){
-        for(auto j : *((*n->rectangle)[d])){
-            del_reg[d][j].push_back(n);
-        }
-    }
-}
-
-// Make the register of the added rectangles
-void Operator::make_add_reg(Rectangle* n){
-    for(int d = 0; d < D; d++){
-        for(auto j : *((*n->rectangle)[d])){
-            add_reg[d][j].push_back(n);
-        }
+    to_del.clear();
+    for(size_t w = 0; w < regUnionResult[0].size(); w++){
+        uint64_t word = regUnionResult[0][w];
+        for(int d = 1; d < D and word; d++)
+            word &= regUnionResult[d][w];
+        for(; word; word &= word - 1)
+            to_del.push_back(slot_map[w*64 + __builtin_ctzll(word)]);
     }
 }
 
-// Clean del_reg and add_reg
-void Operator::clean_temp_registers(){
+// Patch the registers before a lookup in the registers of the operating
+// rectangle, if one of its nodes is dirty. The registers of the clean nodes
+// are up to date, so the lookup sees the partition as it is.
+void Operator::patch_dirty_registers(){
     for(int d = 0; d < D; d++)
-        for(int n = 0; n < N[d]; n++){
-            del_reg[d][n].clear();
-            add_reg[d][n].clear();
-        }
+        for(int node : rect[d])
+            if(dirty_nodes[d][node]){
+                patch_registers();
+                return;
+            }
 }
 
-// Update reg with del_reg and add_reg
-void Operator::update_registers(){
-    //remove to be deleted to reg
-    for(int d = 0; d < D; d++){
-        for(int n = 0; n < N[d]; n++){
-            buffer.clear();
-            set_difference(reg[d][n].begin(), reg[d][n].end(),
-        del_reg[d][n].begin(), del_reg[d][n].end(), back_inserter(buffer));
-            reg[d][n].swap(buffer);
-        }
-    }
-    //add to be added to reg
-    for(int d = 0; d < D; d++){
-        for(int n = 0; n < N[d]; n++){
-            buffer.clear();
-            set_union(reg[d][n].begin(), reg[d][n].end(),
-        add_reg[d][n].begin(), add_reg[d][n].end(), back_inserter(buffer));
-            reg[d][n].swap(buffer);
-        }
+// Replace the rectangles of to_del by new_Rs in the partition, in time
+// proportional to the size of the operation. The ids of to_del are given to
+// new_Rs first. The registers are patched once the batch is full.
+void Operator::replace_rectangles(vector<Rectangle*>& new_Rs){
+    for(Rectangle* e : to_del){
+        edit_registers(e, false);
+        erase_R(e);
+        pool.release(e);
     }
-}
-
 
-// Debugs functions
-void Operator::print_add_reg(){
-    cout << "***print add reg" << endl;
-    for(int d = 0; d < D; d++){
-        cout << "Register dimension " << d << endl;
-        for(int i = 0; i < add_reg[d].size(); i++){
-            cout << "line " << i << "   ";
-            for(auto const &e : add_reg[d][i]){
-                cout << e << " ";
-            }
-            if(!is_sorted(add_reg[d][i].begin(), add_reg[d][i].end()))
-                cout << "line not sorted" << endl;
-            cout << endl;
-        }
-        cout << endl;
+    for(Rectangle* e : new_Rs){
+        insert_R(e);
+        edit_registers(e, true);
     }
+    if(register_edits_size() > register_batch_max)
+        patch_registers();
 }
 
-void Operator::print_del_reg(){
-    cout << "***print dell reg" << endl;
-    for(int d = 0; d < D; d++){
-        cout << "Register dimension " << d << endl;
-        for(int i = 0; i < del_reg[d].size(); i++){
-            cout << "line " << i << "   ";
-            for(auto const &e : del_reg[d][i]){
-                cout << e << " ";
-            }
-            if(!is_sorted(del_reg[d][i].begin(), del_reg[d][i].end()))
-                cout << "line not sorted" << endl;
-            cout << endl;
-        }
-        cout << endl;
-    }
-}
 
+// Debugs functions
 void Operator::print_reg_union(){
     for(int d = 0; d < D; d++){
-        print(regUnionResult[d]);
+        for(size_t id = 0; id < 64*regUnionResult[d].size(); id++)
+            if((regUnionResult[d][id/64] >> (id%64)) & 1)
+                cout << id << " ";
+        cout << endl;
     }
 }
 
@@ -511,10 +387,7 @@ void Operator::print_component_storage(component_storage& inter_diffe){
     cout << "Component strorage inter_diffe" << endl;
     for(int i = 0; i < 2; i++){
         for(int j = 0; j < inter_diffe[0].size(); j++){
-            if(inter_diffe[i][j] == nullptr)
-                cout << "(" << i << "," << j << ")  ptr is null" << endl;
-            else
-                cout << "(" << i << "," << j << ")  " << inter_diffe[i][j]->size() << endl;
+            cout << "(" << i << "," << j << ")  " << inter_diffe[i][j].size() << endl;
         }
     }
 }
@@ -30,8 +30,8 @@ using namespace std;
 using namespace std::chrono;
 
 // Constructor for Optimizer with Data from a Random Matrix Model
-Optimizer::Optimizer(vector<int> N, vector<double> params, double lambda):
-    Objective(N, params, lambda){
+Optimizer::Optimizer(vector<int> N, vector<double> params, double lambda, string layout):
+    Objective(N, params, lambda, layout){
     experiment = "Matrix Generated, params = ";
     for(auto const& w : params){
         experiment += (to_string(w)+",");
@@ -40,25 +40,33 @@ Optimizer::Optimizer(vector<int> N, vector<double> params, double lambda):
 }
 
 // Constructor for Optimizer with Data imported from a file
-Optimizer::Optimizer(string input_filename, double lambda):
-    Objective(input_filename, lambda){
+Optimizer::Optimizer(string input_filename, double lambda, string layout):
+    Objective(input_filename, lambda, layout){
     experiment = "Input Data : " + input_filename;
     init();
 }
 
 // Constructor for Optimizer with Benchmark Data
-Optimizer::Optimizer(string type, int n, double lambda):
-    Objective(type, n, lambda){
+Optimizer::Optimizer(string type, int n, double lambda, string layout):
+    Objective(type, n, lambda, layout){
     experiment = "Benchmark graph type " + type + " scale : " + to_string(n);
     init();
 }
 
+// Constructor for Optimizer over the data of another object, kept read only
+Optimizer::Optimizer(Data_Tree* shared_data, double lambda):
+    Objective(shared_data, lambda){
+    experiment = "Shared data";
+    init();
+}
+
 //Default Constructor
 Optimizer::Optimizer(){
 }
 
 Optimizer::~Optimizer(){
     cout << "Optimizer Destructor" << endl;
+    clear_archive();
 }
 
 
@@ -86,7 +94,7 @@ void Optimizer::make_filenames(string prefix){
 
 // Initialize data vector
 void Optimizer::init_data(){
-    data_size = 13;
+    data_size = 14;
     data.resize(data_size);
     data[0] = cost;     //cost      0
     data[1] = ldkl;     //ldkl      1
@@ -101,6 +109,8 @@ void Optimizer::init_data(){
     data[10] = 0;       //tfind     10
     data[11] = 0;       //tdelta    11
     data[12] = 0;       //tdone     12
+    data[13] = 0;       //alloc     13
+    allocated_before = pool.allocated;
 }
 
 // Fill data vector with class attributes
@@ -121,6 +131,8 @@ void Optimizer::fill_data(){
     data[11] = ope_time.count();
     ope_time = duration_cast<duration<double>>(tdone - tdelta);
     data[12] = ope_time.count();
+    data[13] = pool.allocated - allocated_before;
+    allocated_before = pool.allocated;
 }
 
 void Optimizer::set_parameters(int _nfail_limit, int _ndiv_start, int _ndiv_increm, int _ncycle){
@@ -159,6 +171,7 @@ void Optimizer::gradient_descente_while_cluster(int nfail_limit){
                     nfail = 0;
                     accepted = 1;
                     do_operation();
+                    archive_partition();
                     tdone = steady_clock::now();
                 }
                 else{
@@ -206,6 +219,7 @@ void Optimizer::gradient_descente_while_cluster_succinct(int nfail_limit){
                 nfail = 0;
                 accepted = 1;
                 do_operation();
+                archive_partition();
             }
             else{
                 nfail++;
@@ -245,6 +259,7 @@ void Optimizer::mix_program(){
 
         gradient_descente_while_union(data, datafile);
         best_solution = make_tuple(lambda, cost, copy_partition(), Rsize, info, loss, dkl, ldkl, penalty);
+        start_journal();
 
         for(int cycle = 0; cycle < ncycle; cycle++){
             cout << "Cycle : " << cycle << endl;
@@ -254,6 +269,7 @@ void Optimizer::mix_program(){
             if(get<1>(best_solution) > cost){
                 clean_R(*get<2>(best_solution));
                 best_solution = make_tuple(lambda, cost, copy_partition(), Rsize, info, loss, dkl, ldkl, penalty);
+                start_journal();
                 ndiv_limit = ndiv_start;
             }
             else{
@@ -261,6 +277,7 @@ void Optimizer::mix_program(){
                 ndiv_limit += ndiv_increm;
             }
         }
+        stop_journal();
         tend = steady_clock::now();
         optim_time = duration_cast<duration<double>>(tend - tbegin);
         datafile.close();
@@ -285,6 +302,7 @@ void Optimizer::mix_program_succinct(){
 
     gradient_descente_while_union_succinct();
     best_solution = make_tuple(lambda, cost, copy_partition(), Rsize, info, loss, dkl, ldkl, penalty);
+    start_journal();
 
     for(int cycle = 0; cycle < ncycle; cycle++){
         divide_random_succinct();
@@ -293,6 +311,7 @@ void Optimizer::mix_program_succinct(){
         if(get<1>(best_solution) > cost){
             clean_R(*get<2>(best_solution));
             best_solution = make_tuple(lambda, cost, copy_partition(), Rsize, info, loss, dkl, ldkl, penalty);
+            start_journal();
             ndiv_limit = ndiv_start;
         }
         else{
@@ -300,6 +319,7 @@ void Optimizer::mix_program_succinct(){
             ndiv_limit += ndiv_increm;
         }
     }
+    stop_journal();
     tend = steady_clock::now();
     optim_time = duration_cast<duration<double>>(tend - tbegin);
     // data_tool->print_data_on_file(generated_data_filename);
@@ -322,6 +342,7 @@ void Optimizer::gradient_descente_while_union(vector<double>& data, ofstream& da
                 nfail = 0;
                 accepted = 1;
                 do_operation();
+                archive_partition();
                 tdone = steady_clock::now();
             }
             else{
@@ -361,6 +382,7 @@ void Optimizer::gradient_descente_while_union_succinct(){
                 nfail = 0;
                 accepted = 1;
                 do_operation();
+                archive_partition();
                 tdone = steady_clock::now();
             }
             else{
@@ -387,6 +409,7 @@ void Optimizer::divide_random(vector<double>& data, ofstream& datafile){
             found = 1;
             delta_cost();
             do_operation();
+            archive_partition();
         }
         else{
             found = 0;
@@ -405,6 +428,7 @@ void Optimizer::divide_random_succinct(){
             found = 1;
             delta_cost();
             do_operation();
+            archive_partition();
         }
         else{
             found = 0;
@@ -416,13 +440,11 @@ void Optimizer::divide_random_succinct(){
 // Copy a previously saved partition into the class attributes
 // One can start over an optimization process after using this function
 void Optimizer::restart_from_best(){
-    //Copier la partition de best dans R
-    clean_R();
-    copy_partition(get<2>(best_solution));
-
-    //Reconstruire registres
-    clean_registers();
-    reg_of_R();
+    //Defaire les operations depuis best, ou remettre la partition de best dans R
+    if(journaling)
+        rollback();
+    else
+        copy_partition(get<2>(best_solution));
 
     //Recopier les paramètres objectifs
     cost    = get<1>(best_solution);
@@ -434,6 +456,35 @@ void Optimizer::restart_from_best(){
     penalty = get<8>(best_solution);
 }
 
+// Offer the current partition to the Pareto archive. The archive keeps
+// the partitions not dominated in (Rsize, dkl), one per box of Rsize:
+// the boxes are the powers of 1 + pareto_epsilon, or the values of Rsize
+// if pareto_epsilon is 0. The dkl decreases from a box to the next one.
+void Optimizer::archive_partition(){
+    if(!archiving)
+        return;
+    int box = pareto_epsilon > 0 ? int(log(Rsize)/log1p(pareto_epsilon)) : Rsize;
+    auto it = pareto.lower_bound(box);
+    //Dominated in its box or by a smaller partition
+    if(it != pareto.end() and it->first == box and get<6>(it->second) <= dkl)
+        return;
+    if(it != pareto.begin() and get<6>(prev(it)->second) <= dkl)
+        return;
+    //Drop the partitions it dominates, in its box and in the next ones
+    while(it != pareto.end() and (it->first == box or get<6>(it->second) >= dkl)){
+        clean_R(*get<2>(it->second));
+        it = pareto.erase(it);
+    }
+    pareto.emplace_hint(it, box, make_tuple(lambda, cost, copy_partition(), Rsize, info, loss, dkl, ldkl, penalty));
+}
+
+// Free the partitions of the Pareto archive
+void Optimizer::clear_archive(){
+    for(auto& p : pareto)
+        clean_R(*get<2>(p.second));
+    pareto.clear();
+}
+
 // To initialize the file where the data will be written
 void Optimizer::write_column_names(std::ofstream& file){
     file << "cost ";
@@ -449,6 +500,7 @@ void Optimizer::write_column_names(std::ofstream& file){
     file << "tfind ";
     file << "tdelta ";
     file << "tdone ";
+    file << "alloc ";
     file << endl;
 }
 
@@ -521,18 +573,17 @@ void Optimizer::write_partition(){
 
         partfile << "\"R\":{" << endl;
         for(int r = 0; r < R.size(); r++){
-            data_tool->get_info(R[r]);
-            data_tool->get_non_zero(R[r]);
-            R[r]->info = Brick::info;
+            Query_Result q = data_tool->query(R[r], QUERY_INFO | QUERY_NON_ZERO);
+            R[r]->info = q.info;
             R[r]->doLoss();
             R[r]->doDKL();
 
             partfile << "\"" << r << "\":{\"geometry\":[";
             for(int d = 0; d < D; d++){
                 partfile << "[";
-                for(int e = 0; e < (*R[r]->rectangle)[d]->size(); e++){
-                    partfile << (*(*R[r]->rectangle)[d])[e];
-                    if(e < (*R[r]->rectangle)[d]->size()-1)
+                for(int e = 0; e < (*R[r])[d].size(); e++){
+                    partfile << (*R[r])[d][e];
+                    if(e < (*R[r])[d].size()-1)
                         partfile << ","; 
                 }
                 partfile << "]";
@@ -544,7 +595,7 @@ void Optimizer::write_partition(){
             partfile << "\"loss\" : " << R[r]->loss << ", ";
             partfile << "\"dkl\" : " << R[r]->dkl << ", ";
             partfile << "\"size\" : " << R[r]->size << ", ";
-            partfile << "\"non zero\" : " << Brick::non_zero;
+            partfile << "\"non zero\" : " << q.non_zero;
             partfile << "}";
             if(r < R.size()-1)
                 partfile << ",";
@@ -581,18 +632,17 @@ void Optimizer::write_partition(vector<Rectangle*>& R_){
 
         partfile << "\"R\":{" << endl;
         for(int r = 0; r < R_.size(); r++){
-            data_tool->get_info(R_[r]);
-            data_tool->get_non_zero(R_[r]);
-            R_[r]->info = Brick::info;
+            Query_Result q = data_tool->query(R_[r], QUERY_INFO | QUERY_NON_ZERO);
+            R_[r]->info = q.info;
             R_[r]->doLoss();
             R_[r]->doDKL();
 
             partfile << "\"" << r << "\":{\"geometry\":[";
             for(int d = 0; d < D; d++){
                 partfile << "[";
-                for(int e = 0; e < (*R_[r]->rectangle)[d]->size(); e++){
-                    partfile << (*(*R_[r]->rectangle)[d])[e];
-                    if(e < (*R_[r]->rectangle)[d]->size()-1)
+                for(int e = 0; e < (*R_[r])[d].size(); e++){
+                    partfile << (*R_[r])[d][e];
+                    if(e < (*R_[r])[d].size()-1)
                         partfile << ","; 
                 }
                 partfile << "]";
@@ -604,7 +654,7 @@ void Optimizer::write_partition(vector<Rectangle*>& R_){
             partfile << "\"loss\" : " << R_[r]->loss << ", ";
             partfile << "\"dkl\" : " << R_[r]->dkl << ", ";
             partfile << "\"size\" : " << R_[r]->size << ", ";
-            partfile << "\"non zero\" : " << Brick::non_zero;
+            partfile << "\"non zero\" : " << q.non_zero;
             partfile << "}";
             if(r < R_.size()-1)
                 partfile << ",";
@@ -640,18 +690,17 @@ void Optimizer::write_partition(storage& S){
 
         partfile << "\"R\":{" << endl;
         for(int r = 0; r < get<2>(S)->size(); r++){
-            data_tool->get_info((*get<2>(S))[r]);
-            data_tool->get_non_zero((*get<2>(S))[r]);
-            (*get<2>(S))[r]->info = Brick::info;
+            Query_Result q = data_tool->query((*get<2>(S))[r], QUERY_INFO | QUERY_NON_ZERO);
+            (*get<2>(S))[r]->info = q.info;
             (*get<2>(S))[r]->doLoss();
             (*get<2>(S))[r]->doDKL();
 
             partfile << "\"" << r << "\":{\"geometry\":[";
             for(int d = 0; d < D; d++){
                 partfile << "[";
-                for(int e = 0; e < ( *(((*get<2>(S))[r]) ->rectangle)) [d]->size(); e++){
-                    partfile << (*(( *(((*get<2>(S))[r]) ->rectangle)) [d]))[e];
-                    if(e < ( *(((*get<2>(S))[r]) ->rectangle)) [d]->size()-1)
+                for(int e = 0; e < (*(*get<2>(S))[r])[d].size(); e++){
+                    partfile << (*(*get<2>(S))[r])[d][e];
+                    if(e < (*(*get<2>(S))[r])[d].size()-1)
                         partfile << ",";
                 }
                 partfile << "]";
@@ -663,7 +712,7 @@ void Optimizer::write_partition(storage& S){
             partfile << "\"loss\" : " << (*get<2>(S))[r]->loss << ", ";
             partfile << "\"dkl\" : " << (*get<2>(S))[r]->dkl << ", ";
             partfile << "\"size\" : " << (*get<2>(S))[r]->size << ", ";
-            partfile << "\"non zero\" : " << Brick::non_zero;
+            partfile << "\"non zero\" : " << q.non_zero;
             partfile << "}";
             if(r < get<2>(S)->size()-1)
                 partfile << ",";
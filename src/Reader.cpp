@@ -27,7 +27,7 @@
 #include "Reader.h"
 using namespace std;
 
-Reader::Reader(string input_filename): Data_Tree(), input_filename(input_filename){
+Reader::Reader(string input_filename, string layout): Data_Tree(layout), input_filename(input_filename), mapping(nullptr), mapping_size(0){
 	//cout << "Reader constructor" << endl;
 	path_to_input = "input/";
 	extract_extension();
@@ -35,215 +35,514 @@ Reader::Reader(string input_filename): Data_Tree(), input_filename(input_filenam
 		extract_datas_json();
 	else if (extension == "csv")
 		extract_datas_csv();
+	else if (extension == "bin")
+		extract_datas_bin();
 	else
 		cout << "Extension of data file not known : " << extension << endl;
 	make_brick_spaces();
+	make_layout();
 }
 
-Reader::Reader(){
+Reader::Reader() : mapping(nullptr), mapping_size(0){
 	//cout << "Reader default constructor" << endl;
 }
 
-Reader::~Reader(){}
+Reader::~Reader(){
+	if(mapping != nullptr)
+		munmap(mapping, mapping_size);
+}
 
 void Reader::extract_extension(){
 	extension = input_filename.substr(input_filename.find_last_of(".") + 1);
 	input_filename = path_to_input + input_filename;
 }
 
+//The file is mapped and cut in chunks of whole lines parsed in parallel.
+//Chunks come in the order of the file, so their cells stay sorted.
 void Reader::extract_datas_csv(){
 	cout << input_filename << endl;
-	ifstream data_file;
-	data_file.open(input_filename);
-    if (data_file.is_open())
-    {
-    	int nline = 0;
-    	int ncol = 0;
-    	vector<string> data_line;
-    	while(getline(data_file, line)){
-    		//cout << line << endl;
-    		data_line.clear();
-    		istringstream iss(line);
-    		copy(istream_iterator<string>(iss),
-    			 istream_iterator<string>(),
-     			 back_inserter(data_line));
-
-    		nodes.push_back(new Data_Brick(1));
-    		
-    		for(ncol = 0; ncol < data_line.size(); ncol++){
-    			value = stod(data_line[ncol]);
-    			if(value != 0){
-    				//cout << "Inserting value" << endl;
-	    			nodes[nline]->insert_value(ncol, value);
-    				E++;
-    				Ew += value;
-    			}
-    		}
-    		nline++;
-    	}
-    	N.push_back(nline);
-    	N.push_back(ncol);
-    	D = 2;
-	    data_file.close();
-   	    cout << "Datas Extracted" << endl;
-      	cout << "Ew : " << Ew << endl;
-   	    cout << "E  : " << E  << endl;
-   	    // if(Ew != 1.0)
-   	    // 	normalize();
-   	    cout << "Datas Normalized" << endl;
-    }
-    else
-		cout << "Can't find the csv file " << input_filename << endl;	
+	auto start = chrono::steady_clock::now();
+
+	int fd = open(input_filename.c_str(), O_RDONLY);
+	if(fd < 0){
+		cout << "Can't find the csv file " << input_filename << endl;
+		return;
+	}
+	struct stat file_stat;
+	fstat(fd, &file_stat);
+	size_t size = file_stat.st_size;
+	void* file = (size > 0) ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close(fd);
+	if(file == MAP_FAILED){
+		cout << "Can't map the csv file " << input_filename << endl;
+		return;
+	}
+	madvise(file, size, MADV_SEQUENTIAL);
+	const char* begin = (const char*)file;
+	const char* end = begin + size;
+
+	//At least 1 MB per chunk
+	size_t nchunks = max<size_t>(1, min<size_t>(thread::hardware_concurrency(), size >> 20));
+	vector<Csv_Chunk> chunks(nchunks);
+	const char* cursor = begin;
+	for(size_t c = 0; c < nchunks; c++){
+		chunks[c].begin = cursor;
+		if(c == nchunks-1)
+			cursor = end;
+		else{
+			cursor = max(cursor, begin + size*(c+1)/nchunks);
+			const char* eol = (const char*)memchr(cursor, '\n', end - cursor);
+			cursor = (eol == nullptr) ? end : eol + 1;
+		}
+		chunks[c].end = cursor;
+	}
+
+	vector<thread> workers;
+	for(size_t c = 1; c < nchunks; c++)
+		workers.emplace_back(parse_csv_chunk, ref(chunks[c]));
+	parse_csv_chunk(chunks[0]);
+	for(auto& w : workers)
+		w.join();
+	munmap(file, size);
+
+	//Lines of the chunks are shifted and the cells gathered
+	int nline = 0;
+	int ncol = 0;
+	size_t ncells = 0;
+	for(auto& chunk : chunks){
+		if(chunk.error_line >= 0){
+			cout << "Can't parse line " << nline + chunk.error_line + 1 << " of " << input_filename << endl;
+			return;
+		}
+		nline += chunk.nlines;
+		ncol = max(ncol, chunk.ncols);
+		ncells += chunk.values.size();
+	}
+	vector<int> coords;
+	vector<double> values;
+	coords.reserve(2*ncells);
+	values.reserve(ncells);
+	int shift = 0;
+	for(auto& chunk : chunks){
+		for(size_t e = 0; e < chunk.values.size(); e++){
+			coords.push_back(chunk.coords[2*e] + shift);
+			coords.push_back(chunk.coords[2*e+1]);
+		}
+		values.insert(values.end(), chunk.values.begin(), chunk.values.end());
+		shift += chunk.nlines;
+		Ew += chunk.Ew;
+		chunk = Csv_Chunk();
+	}
+	E += ncells;
+	N.push_back(nline);
+	N.push_back(ncol);
+	D = 2;
+	insert_cells(move(coords), move(values));
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "Datas Extracted : " << size << " bytes in " << seconds << " s ("
+		<< size/seconds/1e6 << " MB/s)" << endl;
+	cout << "Ew : " << Ew << endl;
+	cout << "E  : " << E  << endl;
+}
+
+//Values are separated by spaces, tabs or commas. Zeros are skipped.
+void Reader::parse_csv_chunk(Csv_Chunk& chunk){
+	const char* p = chunk.begin;
+	while(p < chunk.end){
+		int col = 0;
+		while(p < chunk.end and *p != '\n'){
+			if(*p == ' ' or *p == '\t' or *p == ',' or *p == '\r'){
+				p++;
+				continue;
+			}
+			const char* token = p;
+			while(p < chunk.end and *p != ' ' and *p != '\t' and *p != ',' and *p != '\r' and *p != '\n')
+				p++;
+			//Most cells of a dense matrix are a plain 0
+			if(p - token == 1 and *token == '0'){
+				col++;
+				continue;
+			}
+			double value;
+			auto res = from_chars(token, p, value);
+			if(res.ec != errc() or res.ptr != p){
+				chunk.error_line = chunk.nlines;
+				return;
+			}
+			if(value != 0){
+				chunk.coords.push_back(chunk.nlines);
+				chunk.coords.push_back(col);
+				chunk.values.push_back(value);
+				chunk.Ew += value;
+			}
+			col++;
+		}
+		chunk.ncols = max(chunk.ncols, col);
+		chunk.nlines++;
+		p++;
+	}
 }
 
+//The file is mapped and the data tree is built from its columns.
+//With the fiber layout, the last level and the values stay in the mapping.
+void Reader::extract_datas_bin(){
+	cout << input_filename << endl;
+	auto start = chrono::steady_clock::now();
+
+	int fd = open(input_filename.c_str(), O_RDONLY);
+	if(fd < 0){
+		cout << "can't find the file " << input_filename << endl;
+		return;
+	}
+	struct stat file_stat;
+	fstat(fd, &file_stat);
+	mapping_size = file_stat.st_size;
+	if(mapping_size >= sizeof(Binary_Header))
+		mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(mapping == nullptr or mapping == MAP_FAILED){
+		cout << "can't map the file " << input_filename << endl;
+		mapping = nullptr;
+		return;
+	}
+
+	const char* bytes = (const char*)mapping;
+	const Binary_Header* header = (const Binary_Header*)bytes;
+	if(!equal(binary_magic, binary_magic + 8, header->magic)){
+		cout << input_filename << " is not a binary data file" << endl;
+		return;
+	}
+	D = header->D;
+	E = header->E;
+	Ew = header->Ew;
+	size_t ncells = header->ncells;
+	size_t offset = sizeof(Binary_Header);
+	size_t column_bytes = binary_padded(ncells*sizeof(int32_t));
+	if(mapping_size != offset + binary_padded(D*sizeof(int32_t)) + D*column_bytes + ncells*sizeof(double)){
+		cout << "Wrong size for the binary file " << input_filename << endl;
+		return;
+	}
+	const int32_t* sizes = (const int32_t*)(bytes + offset);
+	N.assign(sizes, sizes + D);
+	offset += binary_padded(D*sizeof(int32_t));
+	vector<const int*> columns(D);
+	for(int d = 0; d < D; d++, offset += column_bytes)
+		columns[d] = (const int*)(bytes + offset);
+	const double* values = (const double*)(bytes + offset);
+
+	if(!insert_columns(columns, values, ncells))
+		cout << "Cells of " << input_filename << " are not sorted or out of bounds" << endl;
+	//The bricks copy the cells, the mapping is not needed anymore
+	if(fiber == nullptr){
+		munmap(mapping, mapping_size);
+		mapping = nullptr;
+	}
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "Datas Mapped : " << mapping_size << " bytes in " << seconds << " s" << endl;
+}
 
+//The file is read once, by chunks, and tokenized on the fly.
+//"datas" and "metadatas" can come in any order: the cells are
+//kept in coordinate form and inserted once the whole file is read.
 void Reader::extract_datas_json(){
 	cout << input_filename << endl;
-	ifstream data_file;
-
-	get_metadata(data_file);
-	int dataPos = get_data_pos(data_file);
-
-	data_file.open(input_filename);
-    if (data_file.is_open())
-    {
-    	int end_of_data = 0;
-		data_file.seekg(dataPos, ios::beg);
-	    while (data_file >> word) {
-	    	//cout << word << " - tokens : word[0] " << word[0] << ",  word[word.size()-2] : "
-	    	//	<< word[word.size()-2] << " word[word.size()-3] :" << word[word.size()-3] << endl;
-	    	if(word[word.size()-2] == ']'){
-	    		if(word[word.size()-3] == ']')
-	    			end_of_data = 1;
-	    		clean_word(word);
-	 			value = stod(word);
-	    		make_bricks();
-	    		hyperlinks.clear();
-   				Ew += value;
-	    	}
-			else{
-				clean_word(word);
-				hyperlinks.push_back(stoi(word));
-			}
-			if(end_of_data == 1)
-				break;
+	auto start = chrono::steady_clock::now();
+
+	data_file.open(input_filename, ios::in | ios::binary);
+	if(!data_file.is_open()){
+		cout << "can't find the file " << input_filename << endl;
+		return;
+	}
+	buffer.resize(1 << 20);
+	buffer_pos = 0;
+	buffer_end = 0;
+	bytes_read = 0;
+
+	vector<int> coords;
+	vector<double> values;
+	bool parsed = parse_json(coords, values);
+	data_file.close();
+	buffer = vector<char>();
+	if(!parsed)
+		return;
+	if(coords.size() != values.size()*D){
+		cout << "Cells do not match the dimension " << D << " of the metadatas" << endl;
+		return;
+	}
+
+	//Sizes of the dimensions are deduced from the cells if not given
+	if(N.size() != D){
+		N.assign(D, 0);
+		for(size_t c = 0; c < coords.size(); c++)
+			N[c%D] = max(N[c%D], coords[c]+1);
+	}
+	for(size_t c = 0; c < coords.size(); c++)
+		if(coords[c] < 0 or coords[c] >= N[c%D]){
+			cout << "Node " << coords[c] << " out of dimension " << c%D << " of size " << N[c%D] << endl;
+			return;
 		}
-	    data_file.close();
-        cout << "Datas Extracted" << endl;
-        //cout << "Ew : " << Ew << endl;
-   	    //cout << "E  : " << E  << endl;
+	if(E == 0)
+		E = values.size();
 
-        // if(Ew != 1.0)
-   	    // 	normalize();
-  	    //cout << "Datas Normalized" << endl;
+	insert_cells(move(coords), move(values));
 
-    }
-    else
-    	cout << "can't find the file " << input_filename << endl;
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	cout << "Datas Extracted : " << bytes_read << " bytes in " << seconds << " s ("
+		<< bytes_read/seconds/1e6 << " MB/s)" << endl;
 }
 
+bool Reader::parse_json(vector<int>& coords, vector<double>& values){
+	string key;
+	if(!expect('{'))
+		return false;
+	if(peek_char() == '}')
+		return true;
+	while(true){
+		if(!read_token(key) or !expect(':'))
+			return false;
+		bool parsed;
+		if(key == "datas")
+			parsed = parse_datas(coords, values);
+		else if(key == "metadatas")
+			parsed = parse_metadatas();
+		else
+			parsed = skip_value();
+		if(!parsed)
+			return false;
+		int c = next_char();
+		if(c == '}')
+			return true;
+		if(c != ','){
+			cout << "Malformed json file " << input_filename << " near byte " << position() << endl;
+			return false;
+		}
+	}
+}
 
+//The cells are arrays of D node ids followed by the value,
+//given as strings or numbers
+bool Reader::parse_datas(vector<int>& coords, vector<double>& values){
+	if(!expect('['))
+		return false;
+	if(peek_char() == ']'){
+		next_char();
+		return true;
+	}
+	while(true){
+		if(!expect('['))
+			return false;
+		int n = 0;
+		int c;
+		do{
+			if(n == cell_tokens.size())
+				cell_tokens.emplace_back();
+			if(!read_token(cell_tokens[n++]))
+				return false;
+			c = next_char();
+		} while(c == ',');
+		if(c != ']'){
+			cout << "Malformed json file " << input_filename << " near byte " << position() << endl;
+			return false;
+		}
+		//First cell gives the dimension if the metadatas did not
+		if(D == 0)
+			D = n-1;
+		if(n != D+1){
+			cout << "Cell with " << n-1 << " nodes instead of " << D << " near byte " << position() << endl;
+			return false;
+		}
+		int node;
+		for(int d = 0; d < D; d++){
+			if(!to_int(cell_tokens[d], node))
+				return false;
+			coords.push_back(node);
+		}
+		if(!to_double(cell_tokens[D], value))
+			return false;
+		values.push_back(value);
+		Ew += value;
 
-void Reader::get_metadata(std::ifstream& data_file){
-	data_file.open(input_filename);
-	string meta1 = "dimension";
-	string meta2 = "E";
-	string meta3 = "N";
+		c = next_char();
+		if(c == ']')
+			return true;
+		if(c != ','){
+			cout << "Malformed json file " << input_filename << " near byte " << position() << endl;
+			return false;
+		}
+	}
+}
 
+bool Reader::parse_metadatas(){
+	string key, token;
+	if(!expect('{'))
+		return false;
+	if(peek_char() == '}'){
+		next_char();
+		return true;
+	}
+	while(true){
+		if(!read_token(key) or !expect(':'))
+			return false;
+		if(key == "dimension"){
+			if(!read_token(token) or !to_int(token, D))
+				return false;
+			cout << "D : " << D << endl;
+		}
+		else if(key == "E"){
+			if(!read_token(token) or !to_int(token, E))
+				return false;
+			cout << "E : " << E << endl;
+		}
+		else if(key == "N"){
+			if(!expect('['))
+				return false;
+			N.clear();
+			int c = ',';
+			if(peek_char() == ']')
+				c = next_char();
+			while(c == ','){
+				int n;
+				if(!read_token(token) or !to_int(token, n))
+					return false;
+				N.push_back(n);
+				c = next_char();
+			}
+			if(c != ']'){
+				cout << "Malformed json file " << input_filename << " near byte " << position() << endl;
+				return false;
+			}
+			cout << "N : ";
+			for(int e : N)
+				cout << e << ", ";
+			cout << endl;
+		}
+		else if(!skip_value())
+			return false;
 
-    if (data_file.is_open())
-    {
-	    while (data_file >> word) {
-	    	for(int c = word.size()-1; c >=0; c--)
-	    		if(!isalpha(word[c]))
-	    				word.erase(c,1);
+		int c = next_char();
+		if(c == '}')
+			return true;
+		if(c != ','){
+			cout << "Malformed json file " << input_filename << " near byte " << position() << endl;
+			return false;
+		}
+	}
+}
 
-	    	if(word == meta1)
-	    	{
-	    		data_file >> word;
-	    		for(int c = word.size()-1; c >=0; c--)
-	    			if(!isdigit(word[c]))
-	    				word.erase(c,1);
-				D = stoi(word);
-				cout << "D : " << D << endl;
-			}
-	    	if(word == meta2)
-	    	{
-	    		data_file >> word;
-	    		for(int c = word.size()-1; c >=0; c--)
-	    			if(!isdigit(word[c]))
-	    				word.erase(c,1);
-				E = stoi(word);
-				cout << "E : " << E << endl;
+bool Reader::fill_buffer(){
+	data_file.read(buffer.data(), buffer.size());
+	buffer_pos = 0;
+	buffer_end = data_file.gcount();
+	bytes_read += buffer_end;
+	return buffer_end > 0;
+}
+
+//Next non blank character, not consumed (EOF at the end of the file)
+int Reader::peek_char(){
+	while(true){
+		if(buffer_pos == buffer_end and !fill_buffer())
+			return EOF;
+		char c = buffer[buffer_pos];
+		if(!isspace((unsigned char)c))
+			return c;
+		buffer_pos++;
+	}
+}
+
+int Reader::next_char(){
+	int c = peek_char();
+	if(c != EOF)
+		buffer_pos++;
+	return c;
+}
+
+bool Reader::expect(char c){
+	if(next_char() == c)
+		return true;
+	cout << "Malformed json file " << input_filename << " : '" << c << "' expected near byte " << position() << endl;
+	return false;
+}
+
+//Read a string (without quotes) or a bare number/literal
+bool Reader::read_token(string& token){
+	token.clear();
+	int c = peek_char();
+	if(c == '"'){
+		buffer_pos++;
+		while(true){
+			if(buffer_pos == buffer_end and !fill_buffer()){
+				cout << "Unterminated string in " << input_filename << endl;
+				return false;
 			}
-			if(word == meta3)
-	    	{
-	    		bool noket = true;
-	    		word.clear();
-	    		while(noket){
-		    		data_file >> word;
-		    		noket = no_ket(word);
-		    		for(int c = word.size()-1; c >=0; c--)
-		    			if(!isdigit(word[c]))
-		    				word.erase(c,1);
-					N.push_back(stoi(word));
-				}
-				cout << "N : ";
-				for(int e : N)
-					cout << e << ", ";
-				cout << endl;
+			char ch = buffer[buffer_pos++];
+			if(ch == '"')
+				return true;
+			if(ch == '\\'){
+				if(buffer_pos == buffer_end and !fill_buffer())
+					return false;
+				ch = buffer[buffer_pos++];
 			}
+			token.push_back(ch);
 		}
-		data_file.close();
-		cout << "Metas done" << endl;
-	}
-    else
-    	cout << "can't find the file " << input_filename << " for meta extraction" << endl;
-
-    nodes.resize(N[0], nullptr);
-}
-
-int Reader::get_data_pos(std::ifstream& data_file){
-	data_file.open(input_filename);
-    if (data_file.is_open())
-    {
-    	int dataPos;
-	    while (data_file >> word) {
-	    	for(int c = word.size()-1; c >=0; c--)
-	    		if(!isalpha(word[c]))
-	    				word.erase(c,1);
-			if(word == "datas")
-				dataPos = data_file.tellg();
-			//cout << dataPos << endl;
-		}
-	    data_file.close();	
-    	return dataPos;
-    }
-    else
-    	cout << "file not open" << endl;
-    return -1;
-}
-
-int Reader::clean_word(string& word){
-	for(int c = word.size()-1; c >=0; c--)
-		if(word[c] == '"')
-			word.erase(c,1);
-		else if(word[c] == '[')
-			word.erase(c,1);
-		else if(word[c] == ']')
-			word.erase(c,1);
-		else if(word[c] == ',')
-			word.erase(c,1);
-}
-
-bool Reader::no_ket(string& word){
-	bool ket = true;
-	for(int c = 0; c < word.size(); c++){
-		if(word[c] == ']'){
-			ket = false;
+	}
+	while(buffer_pos < buffer_end or fill_buffer()){
+		char ch = buffer[buffer_pos];
+		if(ch == ',' or ch == ']' or ch == '}' or ch == ':' or isspace((unsigned char)ch))
 			break;
+		token.push_back(ch);
+		buffer_pos++;
+	}
+	if(token.empty())
+		cout << "Malformed json file " << input_filename << " : value expected near byte " << position() << endl;
+	return !token.empty();
+}
+
+//Skip any json value (used for unknown keys)
+bool Reader::skip_value(){
+	string token;
+	int c = peek_char();
+	if(c != '[' and c != '{')
+		return read_token(token);
+	char close = (c == '[') ? ']' : '}';
+	next_char();
+	if(peek_char() == close){
+		next_char();
+		return true;
+	}
+	while(true){
+		if(close == '}' and (!read_token(token) or !expect(':')))
+			return false;
+		if(!skip_value())
+			return false;
+		c = next_char();
+		if(c == close)
+			return true;
+		if(c != ','){
+			cout << "Malformed json file " << input_filename << " near byte " << position() << endl;
+			return false;
 		}
 	}
-	return ket;
 }
 
+bool Reader::to_int(const string& token, int& x){
+	auto res = from_chars(token.data(), token.data() + token.size(), x);
+	if(res.ec == errc() and res.ptr == token.data() + token.size())
+		return true;
+	cout << "Not an integer : \"" << token << "\" near byte " << position() << endl;
+	return false;
+}
+
+bool Reader::to_double(const string& token, double& x){
+	auto res = from_chars(token.data(), token.data() + token.size(), x);
+	if(res.ec == errc() and res.ptr == token.data() + token.size())
+		return true;
+	cout << "Not a number : \"" << token << "\" near byte " << position() << endl;
+	return false;
+}
+
+//Position in the file of the next character to read
+size_t Reader::position(){
+	return bytes_read - buffer_end + buffer_pos;
+}
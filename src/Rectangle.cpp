@@ -28,44 +28,86 @@
 
 using namespace std;
 
-Rectangle::Rectangle(){}
-
 // Constructor
-Rectangle::Rectangle(rect_structure* rectangle) : rectangle{rectangle}{
-	for(auto const& m  : *rectangle)
-		sizes.push_back(m->size());
-	size = accumulate(sizes.begin(), sizes.end(), 1, multiplies<>());
-	//cout << "Creating rectangle " << this << " containing " << rectangle << endl;
+Rectangle::Rectangle(const rect_structure& modules) : id(-1), refs(1), weight(0), info(0), loss(0), dkl(0), length(0){
+	fill(modules.size(), [&](int d) -> const Module& {return modules[d];});
 }
 
 // Copy constructor
 Rectangle::Rectangle(const Rectangle& r):
 	size(r.size),
-	sizes(r.sizes),
-	rectangle(new rect_structure(*(r.rectangle))),
+	id(-1),
+	refs(1),
 	weight(r.weight),
 	info(r.info),
 	loss(r.loss),
 	dkl(r.dkl),
-	weight_check(0),
-	info_check(0),
-	loss_check(0),
-	dkl_check(0)
-{}
+	D(r.D),
+	length(r.length)
+{
+	if(length <= inline_length)
+		copy(r.local, r.local + length, local);
+	else{
+		heap = new int[length];
+		capacity = length;
+		copy(r.heap, r.heap + length, heap);
+	}
+}
 
 Rectangle::~Rectangle(){
-	//cout << "Deleting rectangle " << this << " containing " << rectangle << endl;
-	delete rectangle;
-	//cout << "Rectangle delete" << endl;
+	if(length > inline_length)
+		delete[] heap;
+}
+
+int* Rectangle::reserve(int n){
+	bool on_heap = length > inline_length;
+	length = n;
+	if(on_heap and n > inline_length and capacity >= n)
+		return heap;
+	if(on_heap)
+		delete[] heap;
+	if(n <= inline_length)
+		return local;
+	heap = new int[n];
+	capacity = n;
+	return heap;
+}
+
+//Copy r in place, keeping the buffer when possible
+void Rectangle::assign(const Rectangle& r){
+	int* b = reserve(r.length);
+	copy(r.buffer(), r.buffer() + r.length, b);
+	D = r.D;
+	size = r.size;
+	weight = r.weight;
+	info = r.info;
+	loss = r.loss;
+	dkl = r.dkl;
+	id = -1;
+	refs = 1;
+}
+
+void Rectangle::set_modules(const rect_structure& modules){
+	fill(modules.size(), [&](int d) -> const Module& {return modules[d];});
+}
+
+Rectangle::rect_structure Rectangle::modules() const{
+	rect_structure modules;
+	modules.reserve(D);
+	for(int d = 0; d < D; d++)
+		modules.emplace_back((*this)[d]);
+	return modules;
 }
 
 // Calculate Loss
 void Rectangle::doLoss(){
-	if(weight > 0){
-		loss = -weight*log2(weight/size);
-	}
-	else
-		loss = 0;
+	loss = loss_of(weight, size);
+}
+
+double Rectangle::loss_of(double weight, int size){
+	if(weight > 0)
+		return -weight*log2(weight/size);
+	return 0;
 }
 
 // Calculate DKL
@@ -73,57 +115,21 @@ void Rectangle::doDKL(){
 	dkl = info + loss;
 }
 
-// Check Loss
-void Rectangle::doLossCheck(){
-	if(weight_check > 0)
-		loss_check = -weight_check*log2(weight_check/size);
-	else loss_check = 0;
-}
-
-//Check DKL
-void Rectangle::doDKLCheck(){
-	dkl_check = info_check + loss_check;
-}
-
 // To copy a rectangle
 Rectangle* Rectangle::deep_copy(){
-	Rectangle* R = new Rectangle();
-	R->size = this->size;
-	R->sizes = this->sizes;
-	R->weight = this->weight;
-	R->info = this->info;
-	R->loss = this->loss;
-	R->dkl = this->dkl;
-	R->weight_check = 0;
-	R->info_check = 0;
-	R->loss_check = 0;
-	R->dkl_check = 0;
-	int D = this->sizes.size();
-	R->rectangle = new rect_structure(D);
-	for(int d = 0; d < D; d++){
-    	(*R->rectangle)[d] = make_shared<vector<int>>(); //intersection
-		*((*R->rectangle)[d]) = *((*this->rectangle)[d]);
-	}
-	return R;
+	return new Rectangle(*this);
 }
 
 // Comparison operator between two rectangles
 bool Rectangle::operator==(const Rectangle& r) const
 {
-	for(int i = 0; i < rectangle->size(); i++){
-		if(*((*rectangle)[i]) != *((*r.rectangle)[i]))
+	for(int i = 0; i < D; i++){
+		if((*this)[i] != r[i])
 			return false;
 	}
 	return true;
 }
 
-// Custom indexing
-vector<int> &Rectangle::operator[](int i){
-	return *((*rectangle)[i]);
+size_t Rectangle::memory_footprint() const{
+	return sizeof(Rectangle) + (length > inline_length ? capacity*sizeof(int) : 0);
 }
-
-
-vector<int> &Rectangle::operator[](int i) const
-{
-	return *((*rectangle)[i]);
-}
\ No newline at end of file
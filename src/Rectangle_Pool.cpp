@@ -0,0 +1,112 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Rectangle_Pool.h"
+
+using namespace std;
+
+
+Rectangle_Pool::Rectangle_Pool() : allocated(0), recycled(0){}
+
+Rectangle_Pool::~Rectangle_Pool(){
+	clear();
+}
+
+Rectangle* Rectangle_Pool::make(const rect_structure& modules){
+	return make(modules.size(), [&](int d) -> const Module& {return modules[d];});
+}
+
+Rectangle* Rectangle_Pool::copy(const Rectangle& r){
+	Rectangle* c = take(r.length);
+	if(c == nullptr)
+		return new Rectangle(r);
+	int capacity = held(c);
+	c->assign(r);
+	if(c->length > Rectangle::inline_length and capacity < c->length)
+		allocated++;
+	return c;
+}
+
+//Small rectangles are taken from the small list, large ones from the large
+//list first. A new rectangle is counted with its buffer.
+Rectangle* Rectangle_Pool::take(int length){
+	vector<Rectangle*>& list = (length <= Rectangle::inline_length or large.empty()) ? small : large;
+	if(list.empty()){
+		allocated += (length > Rectangle::inline_length) ? 2 : 1;
+		return nullptr;
+	}
+	Rectangle* r = list.back();
+	list.pop_back();
+	recycled++;
+	return r;
+}
+
+//Count the buffer allocated by the rebuild and forget the previous values
+void Rectangle_Pool::reset(Rectangle* r, int capacity){
+	if(r->length > Rectangle::inline_length and capacity < r->length)
+		allocated++;
+	r->weight = 0;
+	r->info = 0;
+	r->loss = 0;
+	r->dkl = 0;
+	r->id = -1;
+	r->refs = 1;
+}
+
+void Rectangle_Pool::release(Rectangle* r){
+	if(--r->refs > 0)
+		return;
+	if(r->length > Rectangle::inline_length)
+		large.push_back(r);
+	else
+		small.push_back(r);
+}
+
+void Rectangle_Pool::release(vector<Rectangle*>& R){
+	for(Rectangle* r : R)
+		release(r);
+	R.clear();
+}
+
+void Rectangle_Pool::clear(){
+	for(Rectangle* r : small)
+		delete r;
+	for(Rectangle* r : large)
+		delete r;
+	small.clear();
+	large.clear();
+	small.shrink_to_fit();
+	large.shrink_to_fit();
+}
+
+size_t Rectangle_Pool::memory_footprint() const{
+	size_t bytes = (small.capacity() + large.capacity())*sizeof(Rectangle*);
+	for(const Rectangle* r : small)
+		bytes += r->memory_footprint();
+	for(const Rectangle* r : large)
+		bytes += r->memory_footprint();
+	return bytes;
+}
@@ -0,0 +1,583 @@
+/*
+ * This file is part of Greedy Graph Compression.
+ *
+ * Greedy Graph Compression is a C++ implementation of a greedy algorithm
+ * solving the graph compression problem (GCP). Several snippets are
+ * provided in order to introduce the different classes of the project.
+ * For details regarding the GCP, see <https://arxiv.org/abs/1807.06874>.
+ *
+ * Copyright © 2018 Léonard Panichi
+ * (<Leonard.Panichi@gmail.com>)
+ *
+ * Greedy Graph Compression is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Greedy Graph Compression is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Sorted_Set.h"
+#include <iostream>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SORTED_SET_X86
+#endif
+
+using namespace std;
+
+
+// ---------- Scalar kernels ----------
+
+static size_t intersection_scalar(const int* a, size_t na, const int* b, size_t nb, int* out){
+	size_t i = 0, j = 0, k = 0;
+	while(i < na and j < nb){
+		if(a[i] < b[j])
+			i++;
+		else if(b[j] < a[i])
+			j++;
+		else{
+			out[k++] = a[i];
+			i++; j++;
+		}
+	}
+	return k;
+}
+
+static size_t difference_scalar(const int* a, size_t na, const int* b, size_t nb, int* out){
+	size_t i = 0, j = 0, k = 0;
+	while(i < na and j < nb){
+		if(a[i] < b[j])
+			out[k++] = a[i++];
+		else if(b[j] < a[i])
+			j++;
+		else{
+			i++; j++;
+		}
+	}
+	while(i < na)
+		out[k++] = a[i++];
+	return k;
+}
+
+static void split_scalar(const int* a, size_t na, const int* b, size_t nb, int* inter, size_t& ninter, int* diff, size_t& ndiff){
+	size_t i = 0, j = 0;
+	while(i < na and j < nb){
+		if(a[i] < b[j])
+			diff[ndiff++] = a[i++];
+		else if(b[j] < a[i])
+			j++;
+		else{
+			inter[ninter++] = a[i];
+			i++; j++;
+		}
+	}
+	while(i < na)
+		diff[ndiff++] = a[i++];
+}
+
+static size_t intersection64_scalar(const uint64_t* a, size_t na, const uint64_t* b, size_t nb, uint64_t* out){
+	size_t i = 0, j = 0, k = 0;
+	while(i < na and j < nb){
+		if(a[i] < b[j])
+			i++;
+		else if(b[j] < a[i])
+			j++;
+		else{
+			out[k++] = a[i];
+			i++; j++;
+		}
+	}
+	return k;
+}
+
+static size_t match_merge_scalar(const int* a, size_t na, const int* b, size_t nb, int* pos, size_t i = 0, size_t j = 0, size_t k = 0){
+	while(i < na and j < nb){
+		if(a[i] < b[j])
+			i++;
+		else if(b[j] < a[i])
+			j++;
+		else{
+			pos[k++] = i;
+			i++; j++;
+		}
+	}
+	return k;
+}
+
+//Move j to the first value of b not lower than x, in steps doubling in size
+static inline size_t gallop(const int* b, size_t nb, size_t j, int x){
+	size_t step = 1;
+	size_t lo = j;
+	while(j < nb and b[j] < x){
+		lo = j + 1;
+		j += step;
+		step *= 2;
+	}
+	return lower_bound(b + lo, b + min(j, nb), x) - b;
+}
+
+//Walk the small side and search each of its values in the large one
+static size_t match_gallop_scalar(const int* a, size_t na, const int* b, size_t nb, int* pos){
+	size_t k = 0;
+	if(na < nb){
+		size_t j = 0;
+		for(size_t i = 0; i < na and j < nb; i++){
+			j = gallop(b, nb, j, a[i]);
+			if(j < nb and b[j] == a[i])
+				pos[k++] = i;
+		}
+	}
+	else{
+		size_t i = 0;
+		for(size_t j = 0; j < nb and i < na; j++){
+			i = gallop(a, na, i, b[j]);
+			if(i < na and a[i] == b[j])
+				pos[k++] = i++;
+		}
+	}
+	return k;
+}
+
+static size_t match_scalar(const int* a, size_t na, const int* b, size_t nb, int* pos){
+	if(na > nb*Sorted_Set::gallop_ratio or nb > na*Sorted_Set::gallop_ratio)
+		return match_gallop_scalar(a, na, b, nb, pos);
+	return match_merge_scalar(a, na, b, nb, pos);
+}
+
+
+#ifdef SORTED_SET_X86
+
+//End of a blocked difference. The lanes of the current block of a in found are
+//already known to be in b, the other ones are searched in what is left of b.
+static size_t finish_difference(const int* a, size_t na, const int* b, size_t nb, int* out,
+		size_t i, size_t j, size_t k, int found, int width){
+	if(found){
+		for(int lane = 0; lane < width; lane++){
+			if(found & (1 << lane))
+				continue;
+			while(j < nb and b[j] < a[i+lane])
+				j++;
+			if(j == nb or b[j] != a[i+lane])
+				out[k++] = a[i+lane];
+		}
+		i += width;
+	}
+	return k + difference_scalar(a + i, na - i, b + j, nb - j, out + k);
+}
+
+
+//End of a blocked split, same as finish_difference
+static void finish_split(const int* a, size_t na, const int* b, size_t nb, int* inter, size_t& ninter,
+		int* diff, size_t& ndiff, size_t i, size_t j, int found, int width){
+	if(found){
+		for(int lane = 0; lane < width; lane++){
+			if(found & (1 << lane)){
+				inter[ninter++] = a[i+lane];
+				continue;
+			}
+			while(j < nb and b[j] < a[i+lane])
+				j++;
+			if(j < nb and b[j] == a[i+lane])
+				inter[ninter++] = a[i+lane];
+			else
+				diff[ndiff++] = a[i+lane];
+		}
+		i += width;
+	}
+	split_scalar(a + i, na - i, b + j, nb - j, inter, ninter, diff, ndiff);
+}
+
+
+// ---------- Compaction tables ----------
+
+// shuffle4[mask]: pshufb control moving the 32-bit lanes selected by mask to the front
+// permute8[mask]: the 8 lane indices (one per byte) of the lanes selected by mask, first
+struct Compaction_Tables{
+	alignas(16) uint8_t shuffle4[16][16];
+	uint64_t permute8[256];
+
+	Compaction_Tables(){
+		for(int mask = 0; mask < 16; mask++){
+			int k = 0;
+			for(int lane = 0; lane < 4; lane++)
+				if(mask & (1 << lane)){
+					for(int byte = 0; byte < 4; byte++)
+						shuffle4[mask][4*k + byte] = 4*lane + byte;
+					k++;
+				}
+			for(int byte = 4*k; byte < 16; byte++)
+				shuffle4[mask][byte] = 0x80;
+		}
+		for(int mask = 0; mask < 256; mask++){
+			uint64_t indices = 0;
+			int k = 0;
+			for(int lane = 0; lane < 8; lane++)
+				if(mask & (1 << lane))
+					indices |= uint64_t(lane) << (8*k++);
+			permute8[mask] = indices;
+		}
+	}
+};
+
+static const Compaction_Tables tables;
+
+
+// ---------- SSE4.1 kernels (blocks of 4) ----------
+
+__attribute__((target("sse4.1")))
+static inline int in_block_sse(__m128i va, __m128i vb){
+	__m128i m = _mm_cmpeq_epi32(va, vb);
+	m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0,3,2,1))));
+	m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1,0,3,2))));
+	m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2,1,0,3))));
+	return _mm_movemask_ps(_mm_castsi128_ps(m));
+}
+
+__attribute__((target("sse4.1")))
+static inline void compact_sse(__m128i v, int mask, int* out){
+	__m128i control = _mm_load_si128((const __m128i*)tables.shuffle4[mask]);
+	_mm_storeu_si128((__m128i*)out, _mm_shuffle_epi8(v, control));
+}
+
+__attribute__((target("sse4.1")))
+static size_t intersection_sse(const int* a, size_t na, const int* b, size_t nb, int* out){
+	size_t i = 0, j = 0, k = 0;
+	while(i + 4 <= na and j + 4 <= nb){
+		__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+		int mask = in_block_sse(va, vb);
+		compact_sse(va, mask, out + k);
+		k += __builtin_popcount(mask);
+		int a_max = a[i+3], b_max = b[j+3];
+		i += (a_max <= b_max) ? 4 : 0;
+		j += (b_max <= a_max) ? 4 : 0;
+	}
+	return k + intersection_scalar(a + i, na - i, b + j, nb - j, out + k);
+}
+
+//A block of a is written once the blocks of b have passed its largest value
+__attribute__((target("sse4.1")))
+static size_t difference_sse(const int* a, size_t na, const int* b, size_t nb, int* out){
+	size_t i = 0, j = 0, k = 0;
+	int found = 0;	// Lanes of the current block of a met in b so far
+	while(i + 4 <= na and j + 4 <= nb){
+		__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+		found |= in_block_sse(va, vb);
+		int a_max = a[i+3], b_max = b[j+3];
+		if(a_max <= b_max){
+			int mask = ~found & 0xf;
+			compact_sse(va, mask, out + k);
+			k += __builtin_popcount(mask);
+			found = 0;
+			i += 4;
+		}
+		if(b_max <= a_max)
+			j += 4;
+	}
+	return finish_difference(a, na, b, nb, out, i, j, k, found, 4);
+}
+
+__attribute__((target("sse4.1")))
+static void split_sse(const int* a, size_t na, const int* b, size_t nb, int* inter, size_t& ninter, int* diff, size_t& ndiff){
+	size_t i = 0, j = 0;
+	ninter = ndiff = 0;
+	int found = 0;
+	while(i + 4 <= na and j + 4 <= nb){
+		__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+		found |= in_block_sse(va, vb);
+		int a_max = a[i+3], b_max = b[j+3];
+		if(a_max <= b_max){
+			compact_sse(va, found, inter + ninter);
+			ninter += __builtin_popcount(found);
+			compact_sse(va, ~found & 0xf, diff + ndiff);
+			ndiff += 4 - __builtin_popcount(found);
+			found = 0;
+			i += 4;
+		}
+		if(b_max <= a_max)
+			j += 4;
+	}
+	finish_split(a, na, b, nb, inter, ninter, diff, ndiff, i, j, found, 4);
+}
+
+__attribute__((target("sse4.1")))
+static size_t match_sse(const int* a, size_t na, const int* b, size_t nb, int* pos){
+	if(na > nb*Sorted_Set::gallop_ratio or nb > na*Sorted_Set::gallop_ratio)
+		return match_gallop_scalar(a, na, b, nb, pos);
+	size_t i = 0, j = 0, k = 0;
+	const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+	while(i + 4 <= na and j + 4 <= nb){
+		__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+		int mask = in_block_sse(va, vb);
+		compact_sse(_mm_add_epi32(_mm_set1_epi32(i), lanes), mask, pos + k);
+		k += __builtin_popcount(mask);
+		int a_max = a[i+3], b_max = b[j+3];
+		i += (a_max <= b_max) ? 4 : 0;
+		j += (b_max <= a_max) ? 4 : 0;
+	}
+	return match_merge_scalar(a, na, b, nb, pos, i, j, k);
+}
+
+
+// ---------- AVX2 kernels (blocks of 8) ----------
+
+//Bit l is set if lane l of va is in vb
+__attribute__((target("avx2")))
+static inline int in_block_avx2(__m256i va, __m256i vb){
+	const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+	__m256i m = _mm256_cmpeq_epi32(va, vb);
+	for(int r = 1; r < 8; r++){
+		vb = _mm256_permutevar8x32_epi32(vb, rotate);
+		m = _mm256_or_si256(m, _mm256_cmpeq_epi32(va, vb));
+	}
+	return _mm256_movemask_ps(_mm256_castsi256_ps(m));
+}
+
+__attribute__((target("avx2")))
+static inline void compact_avx2(__m256i v, int mask, int* out){
+	__m256i indices = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(tables.permute8[mask]));
+	_mm256_storeu_si256((__m256i*)out, _mm256_permutevar8x32_epi32(v, indices));
+}
+
+__attribute__((target("avx2")))
+static size_t intersection_avx2(const int* a, size_t na, const int* b, size_t nb, int* out){
+	size_t i = 0, j = 0, k = 0;
+	while(i + 8 <= na and j + 8 <= nb){
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+		int mask = in_block_avx2(va, vb);
+		compact_avx2(va, mask, out + k);
+		k += __builtin_popcount(mask);
+		int a_max = a[i+7], b_max = b[j+7];
+		i += (a_max <= b_max) ? 8 : 0;
+		j += (b_max <= a_max) ? 8 : 0;
+	}
+	return k + intersection_scalar(a + i, na - i, b + j, nb - j, out + k);
+}
+
+//A block of a is written once the blocks of b have passed its largest value
+__attribute__((target("avx2")))
+static size_t difference_avx2(const int* a, size_t na, const int* b, size_t nb, int* out){
+	size_t i = 0, j = 0, k = 0;
+	int found = 0;	// Lanes of the current block of a met in b so far
+	while(i + 8 <= na and j + 8 <= nb){
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+		found |= in_block_avx2(va, vb);
+		int a_max = a[i+7], b_max = b[j+7];
+		if(a_max <= b_max){
+			int mask = ~found & 0xff;
+			compact_avx2(va, mask, out + k);
+			k += __builtin_popcount(mask);
+			found = 0;
+			i += 8;
+		}
+		if(b_max <= a_max)
+			j += 8;
+	}
+	return finish_difference(a, na, b, nb, out, i, j, k, found, 8);
+}
+
+__attribute__((target("avx2")))
+static void split_avx2(const int* a, size_t na, const int* b, size_t nb, int* inter, size_t& ninter, int* diff, size_t& ndiff){
+	size_t i = 0, j = 0;
+	ninter = ndiff = 0;
+	int found = 0;
+	while(i + 8 <= na and j + 8 <= nb){
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+		found |= in_block_avx2(va, vb);
+		int a_max = a[i+7], b_max = b[j+7];
+		if(a_max <= b_max){
+			compact_avx2(va, found, inter + ninter);
+			ninter += __builtin_popcount(found);
+			compact_avx2(va, ~found & 0xff, diff + ndiff);
+			ndiff += 8 - __builtin_popcount(found);
+			found = 0;
+			i += 8;
+		}
+		if(b_max <= a_max)
+			j += 8;
+	}
+	finish_split(a, na, b, nb, inter, ninter, diff, ndiff, i, j, found, 8);
+}
+
+__attribute__((target("avx2")))
+static size_t intersection64_avx2(const uint64_t* a, size_t na, const uint64_t* b, size_t nb, uint64_t* out){
+	size_t i = 0, j = 0, k = 0;
+	while(i + 4 <= na and j + 4 <= nb){
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+		__m256i m = _mm256_cmpeq_epi64(va, vb);
+		m = _mm256_or_si256(m, _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0,3,2,1))));
+		m = _mm256_or_si256(m, _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(1,0,3,2))));
+		m = _mm256_or_si256(m, _mm256_cmpeq_epi64(va, _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(2,1,0,3))));
+		//Each 64-bit lane gives two bits, so the 32-bit table applies
+		int mask = _mm256_movemask_ps(_mm256_castsi256_ps(m));
+		compact_avx2(va, mask, (int*)(out + k));
+		k += __builtin_popcount(mask) / 2;
+		uint64_t a_max = a[i+3], b_max = b[j+3];
+		i += (a_max <= b_max) ? 4 : 0;
+		j += (b_max <= a_max) ? 4 : 0;
+	}
+	return k + intersection64_scalar(a + i, na - i, b + j, nb - j, out + k);
+}
+
+//Galloping by blocks of 8, the last block is compared at once
+__attribute__((target("avx2")))
+static inline size_t gallop_avx2(const int* b, size_t nb, size_t j, int x, bool& found){
+	size_t step = 8;
+	while(j + 8 <= nb and b[j+7] < x){
+		size_t next = j + step;
+		if(next + 8 <= nb and b[next+7] < x){
+			j = next + 8;
+			step *= 2;
+		}
+		else{
+			j += 8;
+			step = 8;
+		}
+	}
+	if(j + 8 <= nb){
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+		__m256i vx = _mm256_set1_epi32(x);
+		int lower = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vx, vb)));
+		j += __builtin_popcount(lower);
+	}
+	else
+		while(j < nb and b[j] < x)
+			j++;
+	found = (j < nb and b[j] == x);
+	return j;
+}
+
+__attribute__((target("avx2")))
+static size_t match_gallop_avx2(const int* a, size_t na, const int* b, size_t nb, int* pos){
+	size_t k = 0;
+	bool found;
+	if(na < nb){
+		size_t j = 0;
+		for(size_t i = 0; i < na and j < nb; i++){
+			j = gallop_avx2(b, nb, j, a[i], found);
+			if(found)
+				pos[k++] = i;
+		}
+	}
+	else{
+		size_t i = 0;
+		for(size_t j = 0; j < nb and i < na; j++){
+			i = gallop_avx2(a, na, i, b[j], found);
+			if(found)
+				pos[k++] = i++;
+		}
+	}
+	return k;
+}
+
+__attribute__((target("avx2")))
+static size_t match_avx2(const int* a, size_t na, const int* b, size_t nb, int* pos){
+	if(na > nb*Sorted_Set::gallop_ratio or nb > na*Sorted_Set::gallop_ratio)
+		return match_gallop_avx2(a, na, b, nb, pos);
+	size_t i = 0, j = 0, k = 0;
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	while(i + 8 <= na and j + 8 <= nb){
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b + j));
+		int mask = in_block_avx2(va, vb);
+		compact_avx2(_mm256_add_epi32(_mm256_set1_epi32(i), lanes), mask, pos + k);
+		k += __builtin_popcount(mask);
+		int a_max = a[i+7], b_max = b[j+7];
+		i += (a_max <= b_max) ? 8 : 0;
+		j += (b_max <= a_max) ? 8 : 0;
+	}
+	return match_merge_scalar(a, na, b, nb, pos, i, j, k);
+}
+
+#endif
+
+
+// ---------- Dispatch ----------
+
+struct Kernels{
+	const char* name;
+	size_t (*intersection)(const int*, size_t, const int*, size_t, int*);
+	size_t (*difference)(const int*, size_t, const int*, size_t, int*);
+	size_t (*intersection64)(const uint64_t*, size_t, const uint64_t*, size_t, uint64_t*);
+	void (*split)(const int*, size_t, const int*, size_t, int*, size_t&, int*, size_t&);
+	size_t (*match)(const int*, size_t, const int*, size_t, int*);
+};
+
+static const Kernels scalar_kernels = {"scalar", intersection_scalar, difference_scalar, intersection64_scalar, split_scalar, match_scalar};
+#ifdef SORTED_SET_X86
+static const Kernels sse_kernels = {"sse4.1", intersection_sse, difference_sse, intersection64_scalar, split_sse, match_sse};
+static const Kernels avx2_kernels = {"avx2", intersection_avx2, difference_avx2, intersection64_avx2, split_avx2, match_avx2};
+#endif
+
+static const Kernels* best_kernels(){
+#ifdef SORTED_SET_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return &avx2_kernels;
+	if(__builtin_cpu_supports("sse4.1"))
+		return &sse_kernels;
+#endif
+	return &scalar_kernels;
+}
+
+static const Kernels* kernels = best_kernels();
+
+size_t Sorted_Set::intersection(const int* a, size_t na, const int* b, size_t nb, int* out){
+	return kernels->intersection(a, na, b, nb, out);
+}
+
+size_t Sorted_Set::difference(const int* a, size_t na, const int* b, size_t nb, int* out){
+	return kernels->difference(a, na, b, nb, out);
+}
+
+size_t Sorted_Set::intersection(const uint64_t* a, size_t na, const uint64_t* b, size_t nb, uint64_t* out){
+	return kernels->intersection64(a, na, b, nb, out);
+}
+
+void Sorted_Set::split(const int* a, size_t na, const int* b, size_t nb, int* inter, size_t& ninter, int* diff, size_t& ndiff){
+	ninter = ndiff = 0;
+	kernels->split(a, na, b, nb, inter, ninter, diff, ndiff);
+}
+
+size_t Sorted_Set::match(const int* a, size_t na, const int* b, size_t nb, int* pos){
+	return kernels->match(a, na, b, nb, pos);
+}
+
+string Sorted_Set::isa(){
+	return kernels->name;
+}
+
+bool Sorted_Set::use_isa(const string& name){
+	if(name == "scalar"){
+		kernels = &scalar_kernels;
+		return true;
+	}
+#ifdef SORTED_SET_X86
+	if(name == "sse4.1" and __builtin_cpu_supports("sse4.1")){
+		kernels = &sse_kernels;
+		return true;
+	}
+	if(name == "avx2" and __builtin_cpu_supports("avx2")){
+		kernels = &avx2_kernels;
+		return true;
+	}
+#endif
+	cout << "Instruction set " << name << " is not available" << endl;
+	return false;
+}
@@ -0,0 +1,164 @@
+#include<iostream>
+#include<random>
+#include<chrono>
+#include "Objective.h"
+#include "Sorted_Set.h"
+
+using namespace std;
+using namespace std::chrono;
+
+/*Compare the Sorted_Set kernels with the STL on the arrays met during a run.
+* The partition of a dataset is first optimized for a few thousand operations,
+* then pairs are sampled the way the operators meet them : modules of two
+* rectangles sharing a node, a row of the data and a module, two registers.
+* Usage : bin/greedy-graph-compressor geomedia.json [iterations]
+*/
+
+typedef vector<pair<const vector<int>*, const vector<int>*>> int_pairs;
+typedef vector<pair<const vector<Rectangle*>*, const vector<Rectangle*>*>> reg_pairs;
+
+//Time f on every pair, in ns per pair
+template <typename P, typename F>
+double bench(const P& pairs, F f){
+	size_t total = 0;
+	auto t0 = steady_clock::now();
+	for(int repeat = 0; repeat < 20; repeat++)
+		for(auto& p : pairs)
+			total += f(*p.first, *p.second);
+	double ns = duration<double, nano>(steady_clock::now() - t0).count() / (20.0*pairs.size());
+	if(total == 0)
+		cout << "(no result)" << endl;
+	return ns;
+}
+
+main(int argc, char* argv[]){
+	string filename = argc > 1 ? argv[1] : "geomedia.json";
+	int iterations = argc > 2 ? atoi(argv[2]) : 3000;
+
+	Objective G(filename, 10.0, "fiber");
+	G.micro();
+	G.reg_of_R();
+	G.initialize_objective();
+	for(int i = 0; i < iterations; i++){
+		int found = (i%2 == 0) ? G.find_union_constrained() : G.find_division();
+		if(found){
+			G.delta_cost();
+			if(G.d_cost < 0)
+				G.do_operation();
+			else
+				G.cancel_operation();
+		}
+		else
+			G.clean_operator();
+	}
+	G.build_R();
+	cout << "Partition of " << G.R.size() << " rectangles after " << iterations << " iterations" << endl;
+
+	//Sample the pairs
+	mt19937 generator(1);
+	vector<vector<int>> modules;	// Copies of the modules as plain arrays
+	int_pairs module_pairs, row_pairs;
+	reg_pairs register_pairs;
+	Fiber_Tree* fiber = G.data_tool->fiber;
+	vector<vector<int>> rows(G.N[0]);
+	for(int v = 0; v < G.N[0]; v++)
+		rows[v].assign(fiber->level[1] + fiber->ptr[0][v], fiber->level[1] + fiber->ptr[0][v+1]);
+	//The registers hold ids, the pointer lists they stood for are rebuilt here
+	vector<vector<vector<Rectangle*>>> registers(G.D);
+	for(int d = 0; d < G.D; d++)
+		for(const Id_Set& reg : G.reg[d]){
+			registers[d].emplace_back();
+			reg.for_each([&](int id){ registers[d].back().push_back(G.slot_map[id]); });
+			sort(registers[d].back().begin(), registers[d].back().end());
+		}
+	modules.reserve(G.R.size()*G.D);
+	for(Rectangle* r : G.R)
+		for(int d = 0; d < G.D; d++)
+			modules.emplace_back((*r)[d].begin(), (*r)[d].end());
+
+	for(int s = 0; s < 100000; s++){
+		int a = generator() % G.R.size();
+		int d = generator() % G.D;
+		const vector<int>& module = modules[a*G.D + d];
+		int node = module[generator() % module.size()];
+		const vector<Rectangle*>& neighbours = registers[d][node];
+		int b = G.R_index[neighbours[generator() % neighbours.size()]->id];
+		int e = generator() % G.D;
+		module_pairs.push_back({&modules[a*G.D + e], &modules[b*G.D + e]});
+		int v = modules[a*G.D][generator() % modules[a*G.D].size()];
+		row_pairs.push_back({&rows[v], &modules[a*G.D + 1]});
+		int i = modules[a*G.D][generator() % modules[a*G.D].size()];
+		int j = modules[a*G.D + 1][generator() % modules[a*G.D + 1].size()];
+		register_pairs.push_back({&registers[0][i], &registers[1][j]});
+	}
+
+	//Reference timings with the STL
+	vector<int> out;
+	vector<Rectangle*> out_reg;
+	auto stl_intersection = [&](const vector<int>& a, const vector<int>& b){
+		out.clear();
+		set_intersection(a.begin(), a.end(), b.begin(), b.end(), back_inserter(out));
+		return out.size();
+	};
+	auto stl_difference = [&](const vector<int>& a, const vector<int>& b){
+		out.clear();
+		set_difference(a.begin(), a.end(), b.begin(), b.end(), back_inserter(out));
+		return out.size();
+	};
+	//The loop the bricks used before, searching the smaller side in the larger one
+	auto stl_match = [&](const vector<int>& a, const vector<int>& b){
+		size_t n = 0;
+		auto a_cursor = a.begin();
+		auto b_cursor = b.begin();
+		while(a_cursor != a.end() and b_cursor != b.end()){
+			if(b.size() < a.size()){
+				a_cursor = lower_bound(a_cursor, a.end()-1, *b_cursor);
+				n += (*a_cursor == *b_cursor);
+				b_cursor++;
+			}
+			else{
+				b_cursor = lower_bound(b_cursor, b.end()-1, *a_cursor);
+				n += (*a_cursor == *b_cursor);
+				a_cursor++;
+			}
+		}
+		return n;
+	};
+	auto stl_registers = [&](const vector<Rectangle*>& a, const vector<Rectangle*>& b){
+		out_reg.clear();
+		set_intersection(a.begin(), a.end(), b.begin(), b.end(), back_inserter(out_reg));
+		return out_reg.size();
+	};
+
+	auto kernel_intersection = [&](const vector<int>& a, const vector<int>& b){
+		out.resize(min(a.size(), b.size()) + Sorted_Set::padding);
+		return Sorted_Set::intersection(a.data(), a.size(), b.data(), b.size(), out.data());
+	};
+	auto kernel_difference = [&](const vector<int>& a, const vector<int>& b){
+		out.resize(a.size() + Sorted_Set::padding);
+		return Sorted_Set::difference(a.data(), a.size(), b.data(), b.size(), out.data());
+	};
+	auto kernel_match = [&](const vector<int>& a, const vector<int>& b){
+		size_t n = 0;
+		Sorted_Set::for_each_match(a.data(), a.size(), b.data(), b.size(), [&](int){n++;});
+		return n;
+	};
+	auto kernel_registers = [&](const vector<Rectangle*>& a, const vector<Rectangle*>& b){
+		Sorted_Set::intersection(a, b, out_reg);
+		return out_reg.size();
+	};
+
+	cout << setw(12) << "ns per pair" << setw(14) << "intersection" << setw(12) << "difference"
+		<< setw(12) << "row match" << setw(12) << "registers" << endl;
+	cout << setw(12) << "stl" << setw(14) << bench(module_pairs, stl_intersection)
+		<< setw(12) << bench(module_pairs, stl_difference) << setw(12) << bench(row_pairs, stl_match)
+		<< setw(12) << bench(register_pairs, stl_registers) << endl;
+	for(string isa : {"scalar", "sse4.1", "avx2"}){
+		if(!Sorted_Set::use_isa(isa))
+			continue;
+		cout << setw(12) << isa << setw(14) << bench(module_pairs, kernel_intersection)
+			<< setw(12) << bench(module_pairs, kernel_difference) << setw(12) << bench(row_pairs, kernel_match)
+			<< setw(12) << bench(register_pairs, kernel_registers) << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,28 @@
+#include<iostream>
+#include "Reader.h"
+
+using namespace std;
+
+/*Convert a json or csv data file of the input directory to the binary
+* format, which is mapped in memory instead of being parsed.
+* Usage : bin/greedy-graph-compressor geomedia.json
+* writes input/geomedia.bin
+*/
+
+main(int argc, char* argv[]){
+	if(argc < 2){
+		cout << "Usage : " << argv[0] << " <file.json|file.csv>" << endl;
+		return 1;
+	}
+	string filename = argv[1];
+	Reader data(filename);
+	data.print_metadata();
+
+	string binary = "input/" + filename.substr(0, filename.find_last_of(".")) + ".bin";
+	if(!data.write_binary(binary))
+		return 1;
+
+	/* The binary file is then loaded like any other data file */
+	// Compressor G("geomedia.bin", lambda, gap, nsearch, "fiber");
+	return 0;
+}